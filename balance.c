@@ -0,0 +1,343 @@
+#define _GNU_SOURCE // inotify_init1, nanosleep
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <time.h>
+#include <unistd.h>
+#include "balance.h"
+#include "vm.h"
+
+#define BALANCE_PATH_LEN 256
+#define BALANCE_LINE_LEN 160
+#define BALANCE_POLL_MS 200 // How often the watcher checks if it should stop
+
+// The numbers the game shipped with, a balance file only overrides them
+static const Balance builtin_balance = {
+    {
+        // name, description, health, max health, attack, defense, exp, gold, agility
+        {"Goblin", "", 40, 40, 8, 2, 25, 10, 14},
+        {"Orc", "", 60, 60, 12, 4, 40, 20, 8},
+    },
+    2,
+    {
+        // strength, intelligence, agility, health, mana
+        {20, 10, 12, 130, 35}, // Warrior
+        {10, 20, 12, 75, 90},  // Mage
+        {15, 15, 20, 95, 55},  // Rogue
+    },
+    2, 1, // Damage is attack - defense / 2, at least 1
+    70    // Escape chance
+};
+
+static const char *class_names[NUM_CLASSES] = {"Warrior", "Mage", "Rogue"};
+
+// Read-copy-update: readers only load a pointer, the watcher builds new
+// tables aside and publishes them with one atomic exchange. The old ones
+// are freed after the game thread has passed a quiescent point, at which
+// it can no longer be looking at them. The swap, the quiescent bump and
+// the watcher's reads of the count are all seq_cst: with anything weaker
+// the game thread's next load of the pointer could move ahead of its bump,
+// and the watcher would free tables the game is about to read.
+static Balance *live_balance;          // NULL means builtin_balance
+static unsigned long quiescent_count;  // Bumped by the game thread
+static unsigned long published_count;  // Bumped by the watcher per swap
+static unsigned long failed_count;     // Bumped by the watcher per failed reload
+static unsigned long seen_published;   // Game thread only
+static unsigned long seen_failed;      // Game thread only
+
+static pthread_t watcher_thread;
+static int watcher_running = 0;
+static int watch_fd = -1;
+static int balance_wd = -1;
+static int scripts_wd = -1;
+static char balance_file[BALANCE_PATH_LEN];
+static char scripts_file[BALANCE_PATH_LEN];
+static BalanceStats stats;
+
+const Balance *balance_current(void) {
+    const Balance *balance = __atomic_load_n(&live_balance, __ATOMIC_ACQUIRE);
+    return balance != NULL ? balance : &builtin_balance;
+}
+
+const Enemy *balance_enemy(const Balance *balance, const char *name) {
+    for (int i = 0; i < balance->num_enemies; i++) {
+        if (strcmp(balance->enemies[i].name, name) == 0) return &balance->enemies[i];
+    }
+    return NULL;
+}
+
+// One "keyword values..." line, 0 with error set if it is no good
+static int parse_line(const char *line, Balance *balance, char *error, int error_size) {
+    char keyword[32];
+    char name[32];
+
+    if (sscanf(line, "%31s", keyword) != 1) return 1; // Blank line
+
+    if (strcmp(keyword, "enemy") == 0) {
+        Enemy enemy;
+        memset(&enemy, 0, sizeof(enemy));
+        if (sscanf(line, "%*s %29s %d %d %d %d %d %d", enemy.name, &enemy.max_health, &enemy.attack,
+                   &enemy.defense, &enemy.exp_reward, &enemy.gold_reward, &enemy.agility) != 7 ||
+            enemy.max_health < 1 || enemy.max_health > BALANCE_MAX_HEALTH || enemy.attack < 0 ||
+            enemy.defense < 0 || enemy.agility < 0 || enemy.agility > BALANCE_MAX_AGILITY) {
+            snprintf(error, error_size, "expected 'enemy <name> <health 1-%d> <attack> <defense> <exp> <gold> "
+                     "<agility 0-%d>'", BALANCE_MAX_HEALTH, BALANCE_MAX_AGILITY);
+            return 0;
+        }
+        enemy.health = enemy.max_health;
+
+        // Replaces the template of the same name, or adds a new one
+        int i;
+        for (i = 0; i < balance->num_enemies; i++) {
+            if (strcmp(balance->enemies[i].name, enemy.name) == 0) break;
+        }
+        if (i == MAX_BALANCE_ENEMIES) {
+            snprintf(error, error_size, "too many enemies");
+            return 0;
+        }
+        if (i == balance->num_enemies) balance->num_enemies++;
+        balance->enemies[i] = enemy;
+    } else if (strcmp(keyword, "class") == 0) {
+        ClassPreset preset;
+        if (sscanf(line, "%*s %31s %d %d %d %d %d", name, &preset.strength, &preset.intelligence,
+                   &preset.agility, &preset.health, &preset.mana) != 6 || preset.health < 1 ||
+            preset.health > BALANCE_MAX_HEALTH || preset.agility < 0 || preset.agility > BALANCE_MAX_AGILITY) {
+            snprintf(error, error_size, "expected 'class <name> <strength> <intelligence> <agility 0-%d> "
+                     "<health 1-%d> <mana>'", BALANCE_MAX_AGILITY, BALANCE_MAX_HEALTH);
+            return 0;
+        }
+        int i;
+        for (i = 0; i < NUM_CLASSES; i++) {
+            if (strcmp(class_names[i], name) == 0) break;
+        }
+        if (i == NUM_CLASSES) {
+            snprintf(error, error_size, "unknown class '%s'", name);
+            return 0;
+        }
+        balance->classes[i] = preset;
+    } else if (strcmp(keyword, "damage") == 0) {
+        int divisor, minimum;
+        // A minimum of 0 lets a fight go on forever once attacks stop
+        // getting through, the game and the bot would both hang in it
+        if (sscanf(line, "%*s %d %d", &divisor, &minimum) != 2 || divisor < 1 || minimum < 1) {
+            snprintf(error, error_size, "expected 'damage <defense divisor> <minimum of 1 or more>'");
+            return 0;
+        }
+        balance->damage_defense_divisor = divisor;
+        balance->damage_minimum = minimum;
+    } else if (strcmp(keyword, "escape_chance") == 0) {
+        int chance;
+        if (sscanf(line, "%*s %d", &chance) != 1 || chance < 0 || chance > 100) {
+            snprintf(error, error_size, "expected 'escape_chance <percent>'");
+            return 0;
+        }
+        balance->escape_chance = chance;
+    } else {
+        snprintf(error, error_size, "unknown keyword '%s'", keyword);
+        return 0;
+    }
+    return 1;
+}
+
+int balance_parse(const char *path, Balance *balance, char *error, int error_size) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        snprintf(error, error_size, "can't open %s", path);
+        return 0;
+    }
+
+    *balance = builtin_balance;
+
+    char line[BALANCE_LINE_LEN];
+    char message[120];
+    int line_number = 0;
+    int ok = 1;
+    while (ok && fgets(line, sizeof(line), file) != NULL) {
+        line_number++;
+        char *comment = strchr(line, '#');
+        if (comment != NULL) *comment = '\0';
+
+        if (!parse_line(line, balance, message, sizeof(message))) {
+            snprintf(error, error_size, "%s:%d: %s", path, line_number, message);
+            ok = 0;
+        }
+    }
+
+    fclose(file);
+    return ok;
+}
+
+// Lets the game thread pass a quiescent point so the old tables can go
+static void wait_for_readers(void) {
+    struct timespec pause = {0, BALANCE_GRACE_MS * 1000000L};
+    unsigned long seen = __atomic_load_n(&quiescent_count, __ATOMIC_SEQ_CST);
+
+    // Once stopping, the game thread is done with the tables anyway
+    while (__atomic_load_n(&watcher_running, __ATOMIC_ACQUIRE) &&
+           __atomic_load_n(&quiescent_count, __ATOMIC_SEQ_CST) == seen) {
+        nanosleep(&pause, NULL);
+    }
+}
+
+static void reload_failed(const char *error) {
+    snprintf(stats.last_error, sizeof(stats.last_error), "%s", error);
+    stats.failures++;
+    __atomic_add_fetch(&failed_count, 1, __ATOMIC_RELEASE);
+}
+
+static void reload_balance(void) {
+    char error[sizeof(stats.last_error)];
+    Balance *fresh = malloc(sizeof(Balance));
+
+    if (fresh == NULL) {
+        reload_failed("out of memory");
+        return;
+    }
+    if (!balance_parse(balance_file, fresh, error, sizeof(error))) {
+        free(fresh);
+        reload_failed(error);
+        return;
+    }
+
+    Balance *old = __atomic_exchange_n(&live_balance, fresh, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&published_count, 1, __ATOMIC_RELEASE);
+    stats.reloads++;
+    wait_for_readers();
+    free(old);
+}
+
+static void reload_scripts(void) {
+    char error[sizeof(stats.last_error)];
+    VmScripts *fresh = vm_parse_scripts(scripts_file, error, sizeof(error));
+
+    if (fresh == NULL) {
+        reload_failed(error);
+        return;
+    }
+
+    VmScripts *old = vm_swap_scripts(fresh);
+    __atomic_add_fetch(&published_count, 1, __ATOMIC_RELEASE);
+    stats.reloads++;
+    wait_for_readers();
+    vm_free_scripts(old);
+}
+
+static const char *base_name(const char *path) {
+    const char *slash = strrchr(path, '/');
+    return slash != NULL ? slash + 1 : path;
+}
+
+// Editors often save by renaming a new file over the old one, so watch the
+// directory rather than the file
+static int watch_directory(const char *path) {
+    char dir[BALANCE_PATH_LEN];
+    const char *slash = strrchr(path, '/');
+
+    if (slash == NULL) {
+        strcpy(dir, ".");
+    } else {
+        snprintf(dir, sizeof(dir), "%.*s", (int)(slash - path), path);
+        if (dir[0] == '\0') strcpy(dir, "/");
+    }
+    return inotify_add_watch(watch_fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO);
+}
+
+static void *watcher_main(void *arg) {
+    union {
+        struct inotify_event event; // For the alignment
+        char bytes[4096];
+    } buffer;
+    struct pollfd poll_fd = {watch_fd, POLLIN, 0};
+
+    (void)arg;
+    while (__atomic_load_n(&watcher_running, __ATOMIC_ACQUIRE)) {
+        if (poll(&poll_fd, 1, BALANCE_POLL_MS) <= 0) continue;
+
+        ssize_t length = read(watch_fd, buffer.bytes, sizeof(buffer.bytes));
+        if (length <= 0) continue;
+
+        // A save can fire several events, reload each file once per batch
+        int balance_changed = 0, scripts_changed = 0;
+        for (char *p = buffer.bytes; p < buffer.bytes + length;) {
+            const struct inotify_event *event = (const struct inotify_event *)p;
+            if (event->len > 0) {
+                if (event->wd == balance_wd && strcmp(event->name, base_name(balance_file)) == 0) {
+                    balance_changed = 1;
+                }
+                if (event->wd == scripts_wd && strcmp(event->name, base_name(scripts_file)) == 0) {
+                    scripts_changed = 1;
+                }
+            }
+            p += sizeof(struct inotify_event) + event->len;
+        }
+
+        if (balance_changed) reload_balance();
+        if (scripts_changed) reload_scripts();
+    }
+    return NULL;
+}
+
+int balance_start(const char *balance_path, const char *scripts_path, char *error, int error_size) {
+    int loaded = 0;
+
+    if (watcher_running) return 1;
+    snprintf(balance_file, sizeof(balance_file), "%s", balance_path);
+    snprintf(scripts_file, sizeof(scripts_file), "%s", scripts_path);
+
+    // The first load happens before anyone can be reading
+    Balance *initial = malloc(sizeof(Balance));
+    if (initial != NULL && balance_parse(balance_file, initial, error, error_size)) {
+        __atomic_store_n(&live_balance, initial, __ATOMIC_RELEASE);
+        loaded = 1;
+    } else {
+        free(initial);
+    }
+
+    // Without inotify the game still runs, just without hot reload
+    watch_fd = inotify_init1(IN_CLOEXEC);
+    if (watch_fd < 0) return loaded;
+    balance_wd = watch_directory(balance_file);
+    scripts_wd = watch_directory(scripts_file);
+
+    __atomic_store_n(&watcher_running, 1, __ATOMIC_RELEASE);
+    if (pthread_create(&watcher_thread, NULL, watcher_main, NULL) != 0) {
+        __atomic_store_n(&watcher_running, 0, __ATOMIC_RELEASE);
+        close(watch_fd);
+        watch_fd = -1;
+    }
+    return loaded;
+}
+
+void balance_stop(void) {
+    if (!__atomic_load_n(&watcher_running, __ATOMIC_ACQUIRE)) return;
+
+    // The live tables stay in use, only the watcher goes away
+    __atomic_store_n(&watcher_running, 0, __ATOMIC_RELEASE);
+    pthread_join(watcher_thread, NULL);
+    close(watch_fd);
+    watch_fd = -1;
+}
+
+int balance_quiescent(void) {
+    __atomic_add_fetch(&quiescent_count, 1, __ATOMIC_SEQ_CST);
+
+    unsigned long published = __atomic_load_n(&published_count, __ATOMIC_ACQUIRE);
+    unsigned long failed = __atomic_load_n(&failed_count, __ATOMIC_ACQUIRE);
+    int result = 0;
+    if (failed != seen_failed) {
+        seen_failed = failed;
+        result = -1;
+    }
+    if (published != seen_published) {
+        seen_published = published;
+        result = 1;
+    }
+    return result;
+}
+
+BalanceStats balance_stats(void) {
+    return stats;
+}
@@ -0,0 +1,70 @@
+#ifndef BALANCE_H
+#define BALANCE_H
+
+#include "game.h"
+
+#define MAX_BALANCE_ENEMIES 16
+#define NUM_CLASSES 3
+#define BALANCE_GRACE_MS 1 // How often the reloader checks that the game let go of old tables
+#define BALANCE_MAX_HEALTH 32767 // The bot keeps enemy health in an int16_t
+#define BALANCE_MAX_AGILITY 255  // Far below where initiative_delay() reaches 0
+
+// Quick create classes, in menu order
+typedef enum {
+    CLASS_WARRIOR,
+    CLASS_MAGE,
+    CLASS_ROGUE
+} ClassType;
+
+// Starting stats of a quick create class
+typedef struct {
+    int strength;
+    int intelligence;
+    int agility;
+    int health;
+    int mana;
+} ClassPreset;
+
+// Every number a designer might want to tweak while the game runs
+typedef struct {
+    Enemy enemies[MAX_BALANCE_ENEMIES]; // Templates at full health
+    int num_enemies;
+    ClassPreset classes[NUM_CLASSES];
+    int damage_defense_divisor; // damage = attack - defense / divisor...
+    int damage_minimum;         // ...but at least this, 1 or more so fights end
+    int escape_chance;          // Percent
+} Balance;
+
+typedef struct {
+    unsigned long reloads;
+    unsigned long failures;
+    char last_error[160];
+} BalanceStats;
+
+// The live tables, or the built in ones if nothing was loaded. Only valid
+// until the caller's next balance_quiescent(), don't keep it longer.
+const Balance *balance_current(void);
+
+// Enemy template by name, NULL if there is none
+const Enemy *balance_enemy(const Balance *balance, const char *name);
+
+// Reads a balance file over the built in tables, 0 with error set on failure
+int balance_parse(const char *path, Balance *balance, char *error, int error_size);
+
+// Loads the balance file, then watches it and the scripts with inotify.
+// Changed files are parsed on the watcher thread and swapped in whole.
+// Returns 0 with error set if the balance file could not be loaded, the
+// built in tables are used until it can.
+int balance_start(const char *balance_path, const char *scripts_path, char *error, int error_size);
+void balance_stop(void);
+
+// Call from the game thread whenever it holds no balance or script
+// pointers, once per input loop. Old tables are freed only after this.
+// Returns 1 if new tables went live since the last call, -1 if a reload
+// failed and the old tables were kept, 0 otherwise.
+int balance_quiescent(void);
+
+// Only read this after balance_stop()
+BalanceStats balance_stats(void);
+
+#endif
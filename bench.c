@@ -0,0 +1,316 @@
+// Micro benchmarks for the hot paths that do not need a terminal.
+// Build and run with: make bench && ./bench
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bot.h"
+#include "initiative.h"
+#include "loot.h"
+#include "lore.h"
+#include "vm.h"
+
+#define BENCH_SAMPLES 20000000
+#define BENCH_CHUNK 4096
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Keeps the compiler from throwing away results we never look at
+static volatile long bench_sink;
+
+static void bench_loot_table(int size) {
+    LootTable table;
+    Item item = {"Bench Item", "", ITEM_TYPE_WEAPON, 0, 1};
+    long rarity_counts[6] = {0};
+    long table_rarity[6] = {0};
+    uint64_t rng = 42;
+    int *out = malloc(sizeof(int) * BENCH_CHUNK);
+
+    loot_init(&table, 100);
+    srand(1);
+    for (int i = 0; i < size; i++) {
+        item.rarity = 1 + rand() % 5;
+        table_rarity[item.rarity]++;
+        loot_add(&table, &item);
+    }
+
+    double start = now_seconds();
+    loot_build(&table);
+    double build = now_seconds() - start;
+
+    start = now_seconds();
+    long sum = 0;
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        sum += loot_sample(&table, &rng);
+    }
+    double single = now_seconds() - start;
+    bench_sink = sum;
+
+    start = now_seconds();
+    for (int done = 0; done < BENCH_SAMPLES; done += BENCH_CHUNK) {
+        loot_sample_bulk(&table, &rng, out, BENCH_CHUNK);
+        bench_sink += out[BENCH_CHUNK - 1];
+    }
+    double bulk = now_seconds() - start;
+
+    // Check the draws follow the rarity weights
+    long total_weight = 0;
+    for (int r = 1; r <= 5; r++) total_weight += table_rarity[r] * loot_rarity_weight(r);
+    for (int i = 0; i < BENCH_SAMPLES / 10; i++) {
+        rarity_counts[table.items[loot_sample(&table, &rng)].rarity]++;
+    }
+    long drawn = 0;
+    for (int r = 1; r <= 5; r++) drawn += rarity_counts[r];
+
+    printf("loot  %8d entries  build %7.2f ms  single %5.2f ns/draw  bulk %5.2f ns/draw\n",
+           size, build * 1e3, single / BENCH_SAMPLES * 1e9, bulk / BENCH_SAMPLES * 1e9);
+    printf("      rarity share drawn/expected:");
+    for (int r = 1; r <= 5; r++) {
+        double expected = (double)table_rarity[r] * loot_rarity_weight(r) / total_weight;
+        printf("  %d: %.3f/%.3f", r, (double)rarity_counts[r] / drawn, expected);
+    }
+    printf("\n");
+
+    free(out);
+    loot_free(&table);
+}
+
+// A long fight where combatants keep dying and joining, like a big battle
+static void bench_initiative(int combatants) {
+    InitiativeQueue queue;
+    long turns[64] = {0};
+
+    initiative_init(&queue, combatants);
+    srand(2);
+    for (int i = 0; i < combatants; i++) {
+        initiative_add(&queue, i, i < 64 ? i % 32 : rand() % 32);
+    }
+
+    double start = now_seconds();
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        int who = initiative_next(&queue);
+        if (who < 64) turns[who]++;
+        if ((i & 15) == 0 && who >= 64) {
+            // Someone falls and a fresh combatant takes their place
+            initiative_remove(&queue, who);
+            initiative_add(&queue, who, rand() % 32);
+        }
+    }
+    double elapsed = now_seconds() - start;
+
+    // Turn counts should scale with agility + INITIATIVE_BASE
+    double ratio = (double)turns[31] / turns[0];
+    double expected = (double)initiative_delay(0) / initiative_delay(31);
+
+    printf("initiative %7d combatants  %5.2f ns/turn  turns agility 31 vs 0: %.2f (expected %.2f)\n",
+           combatants, elapsed / BENCH_SAMPLES * 1e9, ratio, expected);
+    initiative_free(&queue);
+}
+
+// Descriptions the size the game stores, every kind in turn
+static void bench_lore(void) {
+    const char *subjects[LORE_NUM_KINDS] = {"Forest", "Iron Sword", "Goblin"};
+    char buffer[100];
+    const long runs = BENCH_SAMPLES / 4;
+    long chars = 0;
+
+    lore_init();
+    double start = now_seconds();
+    for (long i = 0; i < runs; i++) {
+        int kind = (int)(i % LORE_NUM_KINDS);
+        chars += lore_generate((LoreKind)kind, subjects[kind], (unsigned long)i, buffer, sizeof(buffer));
+    }
+    double elapsed = now_seconds() - start;
+    bench_sink = chars;
+
+    printf("lore  %5.2f M descriptions/s  %5.1f ns/char  %4.1f chars each\n",
+           runs / elapsed / 1e6, elapsed / chars * 1e9, (double)chars / runs);
+}
+
+// A potion script the way the game runs it, and a tight loop that shows
+// the cost of dispatching a single instruction
+static void bench_vm(void) {
+    VmProgram potion, loop;
+    VmContext context;
+    char error[80];
+    int health = 10, max_health = 100, value = 30;
+    const long runs = BENCH_SAMPLES / 4;
+
+    vm_assemble("load r0 hp\nload r1 value\nload r2 max_hp\nadd r3 r0 r1\n"
+                "min r3 r3 r2\nstore hp r3\nsub r4 r3 r0\nret r4\n",
+                &potion, error, sizeof(error));
+    // 4 instructions per round, 25000 rounds stays under the jump budget
+    vm_assemble("loadi r0 25000\nloop:\nadd r1 r1 r0\nmax r2 r2 r1\n"
+                "addi r0 r0 -1\njnz r0 loop\nret r1\n",
+                &loop, error, sizeof(error));
+
+    vm_context_init(&context, 3);
+    vm_bind(&context, VM_FIELD_HEALTH, &health);
+    vm_bind(&context, VM_FIELD_MAX_HEALTH, &max_health);
+    vm_bind(&context, VM_FIELD_ITEM_VALUE, &value);
+
+    double start = now_seconds();
+    for (long i = 0; i < runs; i++) {
+        health = 10 + (int)(i & 63);
+        vm_run(&potion, &context);
+        bench_sink += context.result;
+    }
+    double script = now_seconds() - start;
+
+    long loops = runs / 100000;
+    start = now_seconds();
+    for (long i = 0; i < loops; i++) {
+        vm_run(&loop, &context);
+        bench_sink += context.result;
+    }
+    double tight = now_seconds() - start;
+
+    printf("vm    potion script %5.2f ns/run  dispatch %5.2f ns/instruction\n",
+           script / runs * 1e9, tight / (loops * 100000.0) * 1e9);
+}
+
+// The starting world of the game: Town, Forest with two goblins, Cave
+// with an orc and a goblin, and the same loot
+static const Item bench_catalog[] = {
+    {"Health Potion", "", ITEM_TYPE_CONSUMABLE, 30, 2},
+    {"Iron Sword", "", ITEM_TYPE_WEAPON, 5, 3},
+    {"Leather Armor", "", ITEM_TYPE_ARMOR, 3, 2},
+    {"Goblin Ear", "", ITEM_TYPE_QUEST, 0, 1},
+    {"Orc Tusk", "", ITEM_TYPE_QUEST, 0, 2},
+};
+
+static void bench_bot_world(BotWorld *world, BotState *start, EnemyLoot *enemy_loot) {
+    static Location locations[NUM_LOCATIONS];
+    const Enemy goblin = {"Goblin", "", 40, 40, 8, 2, 25, 10, 14};
+    const Enemy orc = {"Orc", "", 60, 60, 12, 4, 40, 20, 8};
+    Adventurer adv;
+
+    memset(locations, 0, sizeof(locations));
+    strcpy(locations[0].name, "Town");
+    strcpy(locations[1].name, "Forest");
+    strcpy(locations[2].name, "Cave");
+    locations[0].items[locations[0].num_items++] = bench_catalog[0];
+    locations[0].items[locations[0].num_items++] = bench_catalog[1];
+    locations[1].items[locations[1].num_items++] = bench_catalog[0];
+    locations[1].enemies[locations[1].num_enemies++] = goblin;
+    locations[1].enemies[locations[1].num_enemies++] = goblin;
+    locations[2].enemies[locations[2].num_enemies++] = orc;
+    locations[2].enemies[locations[2].num_enemies++] = goblin;
+
+    // Goblins drop an ear, orcs a tusk
+    for (int i = 0; i < 2; i++) {
+        strcpy(enemy_loot[i].enemy, i == 0 ? "Goblin" : "Orc");
+        loot_init(&enemy_loot[i].table, 75);
+        loot_add(&enemy_loot[i].table, &bench_catalog[0]);
+        loot_add(&enemy_loot[i].table, &bench_catalog[2]);
+        loot_add(&enemy_loot[i].table, &bench_catalog[3 + i]);
+        loot_build(&enemy_loot[i].table);
+    }
+    bot_world_init(world, bench_catalog, sizeof(bench_catalog) / sizeof(bench_catalog[0]), locations, enemy_loot, 2);
+
+    // A rogue from quick create, fresh in town
+    memset(&adv, 0, sizeof(adv));
+    adv.stats = (Stats){15, 15, 20, 95, 95, 55, 55, 0, 1, 0};
+    adv.gold = 50;
+    bot_observe(start, world, &adv, locations, 7);
+}
+
+// Plays whole games with a policy: 0 random, 1 greedy, 2 MCTS
+static void bench_bot_games(const BotWorld *world, const BotState *start, int policy, int games, int iterations) {
+    const char *names[] = {"random", "greedy", "mcts"};
+    uint64_t rng = 11;
+    long total_score = 0;
+    int deaths = 0;
+    int actions[BOT_NUM_ACTIONS];
+
+    double begin = now_seconds();
+    for (int game = 0; game < games; game++) {
+        BotState state = *start;
+        state.rng = rng++ * 0x9E3779B97F4A7C15ULL;
+
+        int count;
+        while ((count = bot_actions(&state, world, actions)) > 0) {
+            int action;
+            if (policy == 2) {
+                action = bot_mcts(&state, world, iterations, &rng);
+            } else if (policy == 1) {
+                action = bot_greedy(&state, world);
+            } else {
+                action = actions[rand() % count];
+            }
+            bot_step(&state, world, action);
+        }
+        total_score += bot_score(&state);
+        if (state.stats.health <= 0) deaths++;
+    }
+    double elapsed = now_seconds() - begin;
+
+    printf("      %-6s %5d games  score %6.1f  died %5.1f%%  %8.2f ms/game\n", names[policy], games,
+           (double)total_score / games, 100.0 * deaths / games, elapsed / games * 1e3);
+}
+
+// Clones, playouts and whole games on one core
+static void bench_bot(void) {
+    BotWorld world;
+    BotState start;
+    EnemyLoot enemy_loot[2];
+    const int clones = BENCH_SAMPLES * 5;
+    const int playouts = BENCH_SAMPLES / 20;
+    char error[160];
+
+    srand(3);
+    // Play by the shipped rules when run from the repo, built in ones otherwise
+    vm_load_scripts("scripts.vm", error, sizeof(error));
+    bench_bot_world(&world, &start, enemy_loot);
+
+    // Each copy reads the last one, so none can be optimised away
+    BotState *pool = malloc(sizeof(BotState) * 64);
+    pool[0] = start;
+    double begin = now_seconds();
+    for (int i = 1; i <= clones; i++) {
+        pool[i & 63] = pool[(i - 1) & 63];
+        pool[i & 63].turns = (int16_t)i;
+    }
+    double clone = now_seconds() - begin;
+    bench_sink = pool[clones & 63].turns;
+    free(pool);
+
+    long total = 0;
+    begin = now_seconds();
+    for (int i = 0; i < playouts; i++) {
+        BotState sim = start;
+        sim.rng = (uint64_t)i * 0x9E3779B97F4A7C15ULL;
+        total += bot_playout(&sim, &world);
+    }
+    double playout = now_seconds() - begin;
+    bench_sink += total;
+
+    printf("bot   state %zu bytes  %6.1f M clones/s  %6.2f M playouts/s (%d actions each at most)\n",
+           sizeof(BotState), clones / clone / 1e6, playouts / playout / 1e6, BOT_ROLLOUT_DEPTH);
+    bench_bot_games(&world, &start, 0, 10000, 0);
+    bench_bot_games(&world, &start, 1, 10000, 0);
+    bench_bot_games(&world, &start, 2, 100, BOT_MCTS_ITERATIONS);
+
+    for (int i = 0; i < 2; i++) loot_free(&enemy_loot[i].table);
+}
+
+int main(void) {
+    int sizes[] = {16, 10000, 100000, 1000000};
+    int combatants[] = {64, 500, 10000, 100000};
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        bench_loot_table(sizes[i]);
+    }
+    for (size_t i = 0; i < sizeof(combatants) / sizeof(combatants[0]); i++) {
+        bench_initiative(combatants[i]);
+    }
+    bench_lore();
+    bench_vm();
+    bench_bot();
+    return 0;
+}
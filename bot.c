@@ -0,0 +1,392 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "balance.h"
+#include "bot.h"
+#include "initiative.h"
+#include "rng.h"
+#include "rules.h"
+
+// One node per action sequence tried from the root
+typedef struct {
+    int child[BOT_NUM_ACTIONS]; // -1 until tried
+    int visits;
+    double score; // Sum of playout scores through here
+} BotNode;
+
+// Random number in [0, n)
+static int bot_below(uint64_t *rng, int n) {
+    return (int)(((rng_next(rng) >> 32) * (uint64_t)n) >> 32);
+}
+
+static int catalog_index(const BotWorld *world, const char *name) {
+    for (int i = 0; i < world->num_catalog && i < BOT_NO_ITEM; i++) {
+        if (strcmp(world->catalog[i].name, name) == 0) return i;
+    }
+    return BOT_NO_ITEM;
+}
+
+static const Item *bot_item(const BotWorld *world, int index) {
+    return index == BOT_NO_ITEM ? NULL : &world->catalog[index];
+}
+
+static int bot_living(const BotState *state, int location) {
+    int count = 0;
+    for (int i = 0; i < state->num_enemies[location]; i++) {
+        if (state->enemy_health[location][i] > 0) count++;
+    }
+    return count;
+}
+
+int bot_world_init(BotWorld *world, const Item *catalog, int num_catalog, const Location *locations,
+                   const EnemyLoot *enemy_loot, int num_enemy_loot) {
+    memset(world, 0, sizeof(*world));
+    world->catalog = catalog;
+    world->num_catalog = num_catalog;
+
+    for (int i = 0; i < NUM_LOCATIONS; i++) {
+        strcpy(world->location_names[i], locations[i].name);
+        for (int j = 0; j < locations[i].num_enemies; j++) {
+            world->enemies[i][j] = locations[i].enemies[j];
+            world->enemies[i][j].health = world->enemies[i][j].max_health;
+
+            // Look the table up once here rather than by name every kill
+            const LootTable *loot = loot_for_enemy(enemy_loot, num_enemy_loot, locations[i].enemies[j].name);
+            world->enemy_loot[i][j] = loot;
+            if (loot == NULL) continue;
+            if (loot->num_items > BOT_MAX_DROPS) return 0;
+            for (int k = 0; k < loot->num_items; k++) {
+                world->drops[i][j][k] = (uint8_t)catalog_index(world, loot->items[k].name);
+            }
+        }
+    }
+    return 1;
+}
+
+void bot_observe(BotState *state, const BotWorld *world, const Adventurer *adv,
+                 const Location *locations, uint64_t seed) {
+    memset(state, 0, sizeof(*state));
+    state->stats = adv->stats;
+    state->gold = adv->gold;
+    state->rng = seed;
+    state->location = (uint8_t)adv->current_location;
+
+    state->num_items = (uint8_t)adv->num_items;
+    for (int i = 0; i < adv->num_items; i++) {
+        state->items[i] = (uint8_t)catalog_index(world, adv->inventory[i].name);
+    }
+
+    for (int i = 0; i < NUM_LOCATIONS; i++) {
+        state->num_ground[i] = (uint8_t)locations[i].num_items;
+        for (int j = 0; j < locations[i].num_items; j++) {
+            state->ground[i][j] = (uint8_t)catalog_index(world, locations[i].items[j].name);
+        }
+        state->num_enemies[i] = (uint8_t)locations[i].num_enemies;
+        for (int j = 0; j < locations[i].num_enemies; j++) {
+            // The balance loader keeps health in range, clamp in case
+            // something else did not
+            int health = locations[i].enemies[j].health;
+            state->enemy_health[i][j] = (int16_t)(health > INT16_MAX ? INT16_MAX : health);
+        }
+    }
+}
+
+int bot_game_over(const BotState *state) {
+    if (state->stats.health <= 0 || state->turns >= BOT_MAX_TURNS) return 1;
+    for (int i = 0; i < NUM_LOCATIONS; i++) {
+        if (bot_living(state, i) > 0) return 0;
+    }
+    return 1;
+}
+
+long bot_score(const BotState *state) {
+    if (state->stats.health <= 0) return 0;
+    return (long)state->stats.experience + state->gold;
+}
+
+int bot_actions(const BotState *state, const BotWorld *world, int *actions) {
+    int count = 0;
+
+    if (bot_game_over(state)) return 0;
+    if (state->in_encounter) {
+        actions[count++] = BOT_FIGHT;
+        actions[count++] = BOT_RUN;
+        return count;
+    }
+
+    for (int i = 0; i < NUM_LOCATIONS; i++) {
+        actions[count++] = BOT_MOVE + i;
+    }
+    // Picking up with a full pack would throw the item away
+    if (state->num_ground[state->location] > 0 && state->num_items < MAX_INVENTORY_SIZE) {
+        actions[count++] = BOT_PICK_UP;
+    }
+    // Only the first item can be used, just like 'u'
+    const Item *first = state->num_items > 0 ? bot_item(world, state->items[0]) : NULL;
+    if (first != NULL && first->type == ITEM_TYPE_CONSUMABLE) {
+        actions[count++] = BOT_USE_ITEM;
+    }
+    return count;
+}
+
+static void bot_gain_experience(BotState *state, int experience) {
+    state->stats.experience += experience;
+    if (state->stats.experience >= experience_for_level(state->stats.level)) {
+        rules_level_up(&state->stats, &state->gold, rng_next(&state->rng));
+    }
+}
+
+static void bot_defeat_enemy(BotState *state, const BotWorld *world, int index) {
+    int location = state->location;
+    const Enemy *enemy = &world->enemies[location][index];
+
+    bot_gain_experience(state, enemy->exp_reward);
+    state->gold += enemy->gold_reward;
+
+    const LootTable *loot = world->enemy_loot[location][index];
+    const Item *drop = loot != NULL ? loot_roll(loot, &state->rng) : NULL;
+    if (drop != NULL && state->num_items < MAX_INVENTORY_SIZE) {
+        state->items[state->num_items++] = world->drops[location][index][drop - loot->items];
+    }
+}
+
+// The same turn order as combat_round: everyone acts every
+// initiative_delay(agility) ticks. Stops at the player's turn if they
+// are not attacking, which is what a failed escape costs.
+static void bot_combat(BotState *state, const BotWorld *world, int player_attacks) {
+    int location = state->location;
+    int num_enemies = state->num_enemies[location];
+    const Enemy *enemies = world->enemies[location];
+    int16_t *health = state->enemy_health[location];
+    long next[1 + MAX_LOCATION_ENEMIES];
+    unsigned order[1 + MAX_LOCATION_ENEMIES];
+    unsigned next_order = 0;
+
+    // Queued like encounter_enemy does, the player first
+    for (int i = 0; i <= num_enemies; i++) {
+        next[i] = initiative_delay(i == 0 ? state->stats.agility : enemies[i - 1].agility);
+        order[i] = next_order++;
+    }
+
+    while (state->stats.health > 0 && bot_living(state, location) > 0) {
+        // Lowest tick goes first, ties to whoever was queued first, the
+        // same as entry_before in initiative.c. Acting queues them again.
+        int who = 0;
+        for (int i = 1; i <= num_enemies; i++) {
+            if (health[i - 1] > 0 &&
+                (next[i] < next[who] || (next[i] == next[who] && order[i] < order[who]))) {
+                who = i;
+            }
+        }
+        order[who] = next_order++;
+
+        if (who == 0) {
+            if (!player_attacks) return;
+
+            // Player attacks the first enemy still standing
+            int target = 0;
+            while (health[target] <= 0) target++;
+            int damage = calculate_damage(state->stats.strength, enemies[target].defense);
+            health[target] = (int16_t)(health[target] > damage ? health[target] - damage : 0);
+            if (health[target] == 0) {
+                bot_defeat_enemy(state, world, target);
+            }
+            next[0] += initiative_delay(state->stats.agility);
+        } else {
+            int damage = calculate_damage(enemies[who - 1].attack, state->stats.defense);
+            state->stats.health -= damage;
+            if (state->stats.health < 0) state->stats.health = 0;
+            next[who] += initiative_delay(enemies[who - 1].agility);
+        }
+    }
+}
+
+void bot_step(BotState *state, const BotWorld *world, int action) {
+    int location = state->location;
+
+    state->turns++;
+    if (action >= BOT_MOVE && action < BOT_MOVE + NUM_LOCATIONS) {
+        location = action - BOT_MOVE;
+        state->location = (uint8_t)location;
+        rules_enter_location(&state->stats, &state->gold, world->location_names[location],
+                             rng_next(&state->rng));
+        state->in_encounter = bot_living(state, location) > 0;
+        return;
+    }
+
+    switch (action) {
+        case BOT_PICK_UP:
+            if (state->num_ground[location] > 0 && state->num_items < MAX_INVENTORY_SIZE) {
+                state->items[state->num_items++] = state->ground[location][0];
+                state->num_ground[location]--;
+                memmove(state->ground[location], state->ground[location] + 1, state->num_ground[location]);
+            }
+            break;
+        case BOT_USE_ITEM: {
+            const Item *item = state->num_items > 0 ? bot_item(world, state->items[0]) : NULL;
+            if (item != NULL && item->type == ITEM_TYPE_CONSUMABLE) {
+                rules_use_consumable(&state->stats, &state->gold, item, rng_next(&state->rng));
+                state->num_items--;
+                memmove(state->items, state->items + 1, state->num_items);
+            }
+            break;
+        }
+        case BOT_FIGHT:
+            state->in_encounter = 0;
+            bot_combat(state, world, 1);
+            break;
+        case BOT_RUN:
+            state->in_encounter = 0;
+            if (bot_below(&state->rng, 100) >= balance_current()->escape_chance) {
+                bot_combat(state, world, 0);
+            }
+            break;
+    }
+}
+
+long bot_playout(BotState *state, const BotWorld *world) {
+    int actions[BOT_NUM_ACTIONS];
+
+    for (int depth = 0; depth < BOT_ROLLOUT_DEPTH; depth++) {
+        int count = bot_actions(state, world, actions);
+        if (count == 0) break;
+        bot_step(state, world, actions[bot_below(&state->rng, count)]);
+    }
+    return bot_score(state);
+}
+
+// How many of BOT_FIGHT_SAMPLES simulated fights at location end alive
+static int bot_fight_wins(const BotState *state, const BotWorld *world, int location) {
+    uint64_t rng = state->rng;
+    int wins = 0;
+
+    for (int i = 0; i < BOT_FIGHT_SAMPLES; i++) {
+        BotState sim = *state;
+        sim.rng = rng_next(&rng);
+        if (!sim.in_encounter) bot_step(&sim, world, BOT_MOVE + location);
+        if (sim.in_encounter) bot_step(&sim, world, BOT_FIGHT);
+        if (sim.stats.health > 0) wins++;
+    }
+    return wins;
+}
+
+int bot_greedy(const BotState *state, const BotWorld *world) {
+    const Stats *stats = &state->stats;
+    int location = state->location;
+    int low = stats->health * 2 < stats->max_health;
+
+    if (state->in_encounter) {
+        // Fight when at least three in four simulated fights are won
+        return bot_fight_wins(state, world, location) * 4 >= BOT_FIGHT_SAMPLES * 3 ? BOT_FIGHT : BOT_RUN;
+    }
+
+    const Item *first = state->num_items > 0 ? bot_item(world, state->items[0]) : NULL;
+    if (low && first != NULL && first->type == ITEM_TYPE_CONSUMABLE) {
+        return BOT_USE_ITEM;
+    }
+    if (state->num_ground[location] > 0 && state->num_items < MAX_INVENTORY_SIZE) {
+        return BOT_PICK_UP;
+    }
+
+    // Somewhere safe that heals on arrival, e.g. the inn
+    int rest = -1;
+    if (stats->health < stats->max_health) {
+        for (int i = 0; i < NUM_LOCATIONS && rest < 0; i++) {
+            if (bot_living(state, i) > 0) continue;
+            BotState sim = *state;
+            bot_step(&sim, world, BOT_MOVE + i);
+            if (sim.stats.health > stats->health) rest = i;
+        }
+    }
+    if (low && rest >= 0) return BOT_MOVE + rest;
+
+    // Go where the odds are best
+    int target = -1, best_wins = -1;
+    for (int i = 0; i < NUM_LOCATIONS; i++) {
+        if (bot_living(state, i) == 0) continue;
+        int wins = bot_fight_wins(state, world, i);
+        if (wins > best_wins) {
+            best_wins = wins;
+            target = i;
+        }
+    }
+    if (rest >= 0 && best_wins * 4 < BOT_FIGHT_SAMPLES * 3) return BOT_MOVE + rest;
+    if (target >= 0) return BOT_MOVE + target;
+    return rest >= 0 ? BOT_MOVE + rest : BOT_MOVE + location;
+}
+
+int bot_mcts(const BotState *state, const BotWorld *world, int iterations, uint64_t *rng) {
+    int actions[BOT_NUM_ACTIONS];
+    int path[BOT_MAX_TURNS + 2];
+    int count = bot_actions(state, world, actions);
+
+    if (count <= 1) return count == 1 ? actions[0] : -1;
+
+    BotNode *nodes = malloc(sizeof(BotNode) * (iterations + 1));
+    if (nodes == NULL) return bot_greedy(state, world);
+    int num_nodes = 1;
+    memset(nodes[0].child, -1, sizeof(nodes[0].child));
+    nodes[0].visits = 0;
+    nodes[0].score = 0;
+
+    // Scores are divided by the best one seen to keep UCT in [0, 1]
+    double best_score = 1;
+
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        BotState sim = *state;
+        sim.rng = rng_next(rng);
+        int node = 0, depth = 0;
+        path[depth++] = node;
+
+        // Walk down the tree, adding one node for the first untried action
+        while ((count = bot_actions(&sim, world, actions)) > 0) {
+            int pick = -1;
+            double pick_value = -1;
+            for (int i = 0; i < count; i++) {
+                int child = nodes[node].child[actions[i]];
+                if (child < 0) {
+                    pick = actions[i];
+                    break;
+                }
+                double value = nodes[child].score / nodes[child].visits / best_score +
+                               BOT_UCT_EXPLORE * sqrt(log((double)nodes[node].visits) / nodes[child].visits);
+                if (value > pick_value) {
+                    pick_value = value;
+                    pick = actions[i];
+                }
+            }
+
+            bot_step(&sim, world, pick);
+            if (nodes[node].child[pick] < 0) {
+                int added = num_nodes++;
+                memset(nodes[added].child, -1, sizeof(nodes[added].child));
+                nodes[added].visits = 0;
+                nodes[added].score = 0;
+                nodes[node].child[pick] = added;
+                path[depth++] = added;
+                break;
+            }
+            node = nodes[node].child[pick];
+            path[depth++] = node;
+        }
+
+        long score = bot_playout(&sim, world);
+        if (score > best_score) best_score = score;
+        for (int i = 0; i < depth; i++) {
+            nodes[path[i]].visits++;
+            nodes[path[i]].score += score;
+        }
+    }
+
+    // The most tried action is the most trusted one
+    int best = -1, best_visits = -1;
+    for (int action = 0; action < BOT_NUM_ACTIONS; action++) {
+        int child = nodes[0].child[action];
+        if (child >= 0 && nodes[child].visits > best_visits) {
+            best_visits = nodes[child].visits;
+            best = action;
+        }
+    }
+    free(nodes);
+    return best;
+}
@@ -0,0 +1,85 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include <stdint.h>
+#include "game.h"
+#include "loot.h"
+
+#define BOT_MAX_TURNS 200      // A game the bot plays ends after this many actions
+#define BOT_ROLLOUT_DEPTH 40   // Random actions per MCTS playout
+#define BOT_FIGHT_SAMPLES 16   // Simulated fights before the greedy bot commits
+#define BOT_MAX_DROPS 16       // Entries per enemy loot table
+#define BOT_UCT_EXPLORE 1.4
+#define BOT_MCTS_ITERATIONS 2000 // Per move when the MCTS bot plays the game
+#define BOT_DELAY_MS 100         // Pause between moves in the game, roughly human pace
+#define BOT_NO_ITEM 0xFF       // Anything not in the catalog
+
+// What the bot can do, the same choices a player has
+typedef enum {
+    BOT_MOVE,     // BOT_MOVE + i moves to location i
+    BOT_PICK_UP = BOT_MOVE + NUM_LOCATIONS,
+    BOT_USE_ITEM, // Uses the first item in the inventory, like 'u'
+    BOT_FIGHT,
+    BOT_RUN,
+    BOT_NUM_ACTIONS
+} BotAction;
+
+// Content the simulation needs that never changes during a game. Items
+// are kept as indexes into the catalog.
+typedef struct {
+    const Item *catalog;
+    int num_catalog;
+    char location_names[NUM_LOCATIONS][MAX_LOCATION_NAME_LEN];
+    Enemy enemies[NUM_LOCATIONS][MAX_LOCATION_ENEMIES]; // At full health
+    const LootTable *enemy_loot[NUM_LOCATIONS][MAX_LOCATION_ENEMIES]; // NULL if it drops nothing
+    uint8_t drops[NUM_LOCATIONS][MAX_LOCATION_ENEMIES][BOT_MAX_DROPS]; // Catalog index per loot entry
+} BotWorld;
+
+// Everything that changes during a game, about 120 bytes with no
+// pointers, so search can clone it with a plain struct assignment
+typedef struct {
+    Stats stats;
+    int gold;
+    uint64_t rng;
+    int16_t turns;
+    uint8_t location;
+    uint8_t in_encounter; // Enemies are here, the only choices are fight or run
+    uint8_t num_items;
+    uint8_t items[MAX_INVENTORY_SIZE];
+    uint8_t num_ground[NUM_LOCATIONS];
+    uint8_t ground[NUM_LOCATIONS][MAX_LOCATION_ITEMS];
+    int16_t enemy_health[NUM_LOCATIONS][MAX_LOCATION_ENEMIES]; // Clamped to INT16_MAX
+    uint8_t num_enemies[NUM_LOCATIONS];
+} BotState;
+
+// Returns 0 if the loot tables hold more entries than the bot can map
+int bot_world_init(BotWorld *world, const Item *catalog, int num_catalog, const Location *locations,
+                   const EnemyLoot *enemy_loot, int num_enemy_loot);
+
+// Takes a snapshot of a game in progress
+void bot_observe(BotState *state, const BotWorld *world, const Adventurer *adv,
+                 const Location *locations, uint64_t seed);
+
+// Fills actions (room for BOT_NUM_ACTIONS) with what is possible now
+int bot_actions(const BotState *state, const BotWorld *world, int *actions);
+
+void bot_step(BotState *state, const BotWorld *world, int action);
+
+// Dead, out of turns or nothing left to fight
+int bot_game_over(const BotState *state);
+
+// Higher is better, 0 when dead
+long bot_score(const BotState *state);
+
+// Rule based: heal when low, loot, fight what simulation says it can beat
+int bot_greedy(const BotState *state, const BotWorld *world);
+
+// Open loop UCT. The tree holds action sequences rather than states, each
+// iteration replays them on a clone with fresh random numbers, so the bot
+// can't learn the future dice rolls.
+int bot_mcts(const BotState *state, const BotWorld *world, int iterations, uint64_t *rng);
+
+// Plays up to BOT_ROLLOUT_DEPTH random actions, returns the score
+long bot_playout(BotState *state, const BotWorld *world);
+
+#endif
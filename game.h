@@ -0,0 +1,80 @@
+#ifndef GAME_H
+#define GAME_H
+
+#define MAX_NAME_LEN 50
+#define MAX_INVENTORY_SIZE 10
+#define MAX_ITEM_NAME_LEN 20
+#define NUM_LOCATIONS 3
+#define MAX_ENEMY_NAME_LEN 30
+#define MAX_LOCATION_NAME_LEN 30
+#define MAX_LOCATION_ENEMIES 4
+#define MAX_LOCATION_ITEMS 5
+#define SCRIPTS_PATH "scripts.vm"
+#define BALANCE_PATH "balance.txt"
+
+// Item types
+typedef enum {
+    ITEM_TYPE_WEAPON,
+    ITEM_TYPE_ARMOR,
+    ITEM_TYPE_CONSUMABLE,
+    ITEM_TYPE_QUEST
+} ItemType;
+
+// Item structure
+typedef struct {
+    char name[MAX_ITEM_NAME_LEN];
+    char description[100];
+    ItemType type;
+    int value; // Could be attack bonus, defense bonus, or healing amount
+    int rarity; // 1-5 scale (5 being rarest)
+} Item;
+
+// Enemy structure
+typedef struct {
+    char name[MAX_ENEMY_NAME_LEN];
+    char description[100];
+    int health;
+    int max_health;
+    int attack;
+    int defense;
+    int exp_reward;
+    int gold_reward;
+    int agility; // Decides how often it gets a turn
+} Enemy;
+
+// Stats structure
+typedef struct {
+    int strength;
+    int intelligence;
+    int agility;
+    int health;
+    int max_health;
+    int mana;
+    int max_mana;
+    int experience;
+    int level;
+    int defense;
+} Stats;
+
+// Adventurer structure
+typedef struct {
+    char name[MAX_NAME_LEN];
+    Stats stats;
+    Item inventory[MAX_INVENTORY_SIZE];
+    int num_items;
+    int current_location;
+    int gold;
+} Adventurer;
+
+// Location structure
+typedef struct {
+    char name[MAX_LOCATION_NAME_LEN];
+    char description[100];
+    int has_enemy;
+    int num_enemies;
+    Enemy enemies[MAX_LOCATION_ENEMIES];
+    int num_items;
+    Item items[MAX_LOCATION_ITEMS];
+} Location;
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stddef.h>
+
+#define HASH_START 2166136261UL
+
+// FNV-1a, good enough to tell screens, strings and names apart. Start from
+// HASH_START, or from an earlier result to hash several pieces in turn.
+static inline unsigned long hash_bytes(unsigned long hash, const void *data, size_t size) {
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+#endif
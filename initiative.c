@@ -0,0 +1,110 @@
+#include <stdlib.h>
+#include <string.h>
+#include "initiative.h"
+
+static int entry_before(const InitiativeEntry *a, const InitiativeEntry *b) {
+    return a->time < b->time || (a->time == b->time && a->order < b->order);
+}
+
+static void heap_set(InitiativeQueue *queue, int index, const InitiativeEntry *entry) {
+    queue->heap[index] = *entry;
+    queue->position[entry->combatant] = index;
+}
+
+static void sift_up(InitiativeQueue *queue, int index) {
+    InitiativeEntry entry = queue->heap[index];
+
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (!entry_before(&entry, &queue->heap[parent])) break;
+        heap_set(queue, index, &queue->heap[parent]);
+        index = parent;
+    }
+    heap_set(queue, index, &entry);
+}
+
+static void sift_down(InitiativeQueue *queue, int index) {
+    InitiativeEntry entry = queue->heap[index];
+
+    for (;;) {
+        int child = index * 2 + 1;
+        if (child >= queue->count) break;
+        if (child + 1 < queue->count && entry_before(&queue->heap[child + 1], &queue->heap[child])) {
+            child++;
+        }
+        if (!entry_before(&queue->heap[child], &entry)) break;
+        heap_set(queue, index, &queue->heap[child]);
+        index = child;
+    }
+    heap_set(queue, index, &entry);
+}
+
+int initiative_init(InitiativeQueue *queue, int capacity) {
+    memset(queue, 0, sizeof(*queue));
+    queue->heap = malloc(sizeof(InitiativeEntry) * capacity);
+    queue->position = malloc(sizeof(int) * capacity);
+    if (queue->heap == NULL || queue->position == NULL) {
+        initiative_free(queue);
+        return 0;
+    }
+
+    queue->capacity = capacity;
+    for (int i = 0; i < capacity; i++) queue->position[i] = -1;
+    return 1;
+}
+
+void initiative_free(InitiativeQueue *queue) {
+    free(queue->heap);
+    free(queue->position);
+    memset(queue, 0, sizeof(*queue));
+}
+
+int initiative_delay(int agility) {
+    if (agility < 0) agility = 0;
+    return INITIATIVE_SCALE / (agility + INITIATIVE_BASE);
+}
+
+void initiative_add(InitiativeQueue *queue, int combatant, int agility) {
+    if (combatant < 0 || combatant >= queue->capacity || queue->position[combatant] >= 0) return;
+
+    InitiativeEntry entry;
+    entry.delay = initiative_delay(agility);
+    entry.time = queue->now + entry.delay;
+    entry.order = queue->next_order++;
+    entry.combatant = combatant;
+
+    heap_set(queue, queue->count++, &entry);
+    sift_up(queue, queue->count - 1);
+}
+
+void initiative_remove(InitiativeQueue *queue, int combatant) {
+    if (combatant < 0 || combatant >= queue->capacity) return;
+
+    int index = queue->position[combatant];
+    if (index < 0) return;
+
+    queue->position[combatant] = -1;
+    queue->count--;
+    if (index == queue->count) return;
+
+    // Move the last entry into the hole and let it find its place
+    heap_set(queue, index, &queue->heap[queue->count]);
+    if (index > 0 && entry_before(&queue->heap[index], &queue->heap[(index - 1) / 2])) {
+        sift_up(queue, index);
+    } else {
+        sift_down(queue, index);
+    }
+}
+
+int initiative_next(InitiativeQueue *queue) {
+    if (queue->count == 0) return -1;
+
+    // Reschedule the top in place, a single sift instead of pop and push
+    InitiativeEntry *top = &queue->heap[0];
+    int combatant = top->combatant;
+    queue->now = top->time;
+    top->time += top->delay;
+    top->order = queue->next_order++;
+    sift_down(queue, 0);
+    return combatant;
+}
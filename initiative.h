@@ -0,0 +1,39 @@
+#ifndef INITIATIVE_H
+#define INITIATIVE_H
+
+#define INITIATIVE_SCALE 1200 // Ticks in a turn of someone with no agility...
+#define INITIATIVE_BASE 10    // ...divided by agility plus this
+
+// One queued combatant, whoever has the lowest time acts next
+typedef struct {
+    long time;      // Tick of the next turn
+    unsigned order; // When it was queued, breaks ties first come first served
+    int delay;      // Ticks between turns, lower for more agile combatants
+    int combatant;
+} InitiativeEntry;
+
+// Binary min-heap of combatants ids 0..capacity-1. position lets us find
+// and remove a combatant (e.g. one that died) in O(log n) as well.
+typedef struct {
+    InitiativeEntry *heap;
+    int *position; // Heap index per combatant, -1 when not queued
+    int count;
+    int capacity;
+    unsigned next_order;
+    long now; // Tick of the turn being played
+} InitiativeQueue;
+
+int initiative_init(InitiativeQueue *queue, int capacity);
+void initiative_free(InitiativeQueue *queue);
+
+// Ticks between turns for a given agility
+int initiative_delay(int agility);
+
+// Queues a combatant, its first turn comes one delay from now
+void initiative_add(InitiativeQueue *queue, int combatant, int agility);
+void initiative_remove(InitiativeQueue *queue, int combatant);
+
+// Returns whose turn it is and queues their next turn, -1 if nobody is left
+int initiative_next(InitiativeQueue *queue);
+
+#endif
@@ -0,0 +1,276 @@
+#include <ncurses.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "hash.h"
+#include "layout.h"
+
+static Layout layout_cache[LAYOUT_CACHE_SIZE];
+
+// Decodes one UTF-8 sequence, returns the number of bytes it used.
+// Broken sequences are treated as a single byte so we always make progress.
+static int utf8_decode(const char *text, int len, unsigned int *codepoint) {
+    const unsigned char *s = (const unsigned char *)text;
+    int need;
+    unsigned int cp;
+
+    if (s[0] < 0x80) {
+        *codepoint = s[0];
+        return 1;
+    } else if ((s[0] & 0xE0) == 0xC0) {
+        need = 1;
+        cp = s[0] & 0x1F;
+    } else if ((s[0] & 0xF0) == 0xE0) {
+        need = 2;
+        cp = s[0] & 0x0F;
+    } else if ((s[0] & 0xF8) == 0xF0) {
+        need = 3;
+        cp = s[0] & 0x07;
+    } else {
+        *codepoint = s[0];
+        return 1;
+    }
+
+    if (need >= len) {
+        *codepoint = s[0];
+        return 1;
+    }
+    for (int i = 1; i <= need; i++) {
+        if ((s[i] & 0xC0) != 0x80) {
+            *codepoint = s[0];
+            return 1;
+        }
+        cp = (cp << 6) | (s[i] & 0x3F);
+    }
+    *codepoint = cp;
+    return need + 1;
+}
+
+// Columns a codepoint takes up: combining marks are zero width,
+// CJK and emoji are double width, everything else is one column
+static int codepoint_width(unsigned int cp) {
+    if (cp < 0x300) return 1;
+    if ((cp >= 0x0300 && cp <= 0x036F) ||
+        (cp >= 0x1AB0 && cp <= 0x1AFF) ||
+        (cp >= 0x1DC0 && cp <= 0x1DFF) ||
+        (cp >= 0x200B && cp <= 0x200F) ||
+        (cp >= 0x20D0 && cp <= 0x20FF) ||
+        (cp >= 0xFE00 && cp <= 0xFE0F) ||
+        (cp >= 0xFE20 && cp <= 0xFE2F)) {
+        return 0;
+    }
+    if ((cp >= 0x1100 && cp <= 0x115F) ||
+        (cp >= 0x2E80 && cp <= 0xA4CF && cp != 0x303F) ||
+        (cp >= 0xAC00 && cp <= 0xD7A3) ||
+        (cp >= 0xF900 && cp <= 0xFAFF) ||
+        (cp >= 0xFE30 && cp <= 0xFE4F) ||
+        (cp >= 0xFF00 && cp <= 0xFF60) ||
+        (cp >= 0xFFE0 && cp <= 0xFFE6) ||
+        (cp >= 0x1F300 && cp <= 0x1F64F) ||
+        (cp >= 0x1F900 && cp <= 0x1F9FF) ||
+        (cp >= 0x20000 && cp <= 0x3FFFD)) {
+        return 2;
+    }
+    return 1;
+}
+
+int utf8_width(const char *text, int len) {
+    int width = 0;
+    int pos = 0;
+    while (pos < len) {
+        unsigned int cp;
+        pos += utf8_decode(text + pos, len - pos, &cp);
+        width += codepoint_width(cp);
+    }
+    return width;
+}
+
+static void layout_add_line(Layout *layout, int start, int len, int width) {
+    LayoutLine *line = &layout->lines[layout->num_lines++];
+    line->start = (unsigned short)start;
+    line->len = (unsigned short)len;
+    line->width = (unsigned short)width;
+}
+
+// Greedy word wrap: break at the last space that fits, hard break words
+// that are wider than the terminal, and honour explicit newlines. Spaces
+// at a break belong to neither line.
+static void layout_wrap(Layout *layout) {
+    const char *text = layout->text;
+    int len = layout->text_len;
+    int pos = 0;
+    int wrapped = 0; // The last line was broken by us, not by a newline
+
+    layout->num_lines = 0;
+    while (pos < len && layout->num_lines < LAYOUT_MAX_LINES) {
+        if (wrapped) {
+            while (pos < len && text[pos] == ' ') pos++;
+            if (pos == len) break;
+        }
+
+        int start = pos;
+        int end = pos;
+        int width = 0;
+        int space = -1;
+        int space_width = 0;
+        int next;
+
+        while (end < len) {
+            unsigned int cp;
+            int n = utf8_decode(text + end, len - end, &cp);
+            int w = codepoint_width(cp);
+            if (cp == '\n' || width + w > layout->cols) break;
+            if (cp == ' ') {
+                space = end;
+                space_width = width;
+            }
+            width += w;
+            end += n;
+        }
+
+        wrapped = end < len && text[end] != '\n';
+        if (end < len && (text[end] == '\n' || text[end] == ' ')) {
+            next = end + 1;
+        } else if (end < len && space > start) {
+            end = space;
+            width = space_width;
+            next = space + 1;
+        } else if (end == start && end < len) {
+            // A single character wider than the terminal, print it anyway
+            unsigned int cp;
+            end += utf8_decode(text + end, len - end, &cp);
+            width = codepoint_width(cp);
+            next = end;
+        } else {
+            next = end;
+        }
+
+        if (wrapped) {
+            while (end > start && text[end - 1] == ' ') {
+                end--;
+                width--;
+            }
+        }
+
+        layout_add_line(layout, start, end - start, width);
+        pos = next;
+    }
+
+    // Out of lines with text left over, cut the last line short enough
+    // to end it with "..."
+    while (pos < len && (text[pos] == ' ' || text[pos] == '\n')) pos++;
+    layout->truncated = pos < len;
+    if (layout->truncated) {
+        LayoutLine *last = &layout->lines[layout->num_lines - 1];
+        int end = last->start;
+        int width = 0;
+        while (end < last->start + last->len) {
+            unsigned int cp;
+            int n = utf8_decode(text + end, last->start + last->len - end, &cp);
+            int w = codepoint_width(cp);
+            if (width + w + 3 > layout->cols) break;
+            width += w;
+            end += n;
+        }
+        last->len = (unsigned short)(end - last->start);
+        last->width = (unsigned short)(width + 3);
+    }
+}
+
+const Layout *layout_text(const char *text, int len, int cols) {
+    if (len >= LAYOUT_MAX_TEXT) len = LAYOUT_MAX_TEXT - 1;
+    if (cols < 1) cols = 1;
+
+    unsigned long hash = hash_bytes(HASH_START, text, (size_t)len);
+    Layout *layout = &layout_cache[(hash ^ ((unsigned long)cols * 2654435761UL)) % LAYOUT_CACHE_SIZE];
+
+    if (layout->cols == cols && layout->hash == hash && layout->text_len == len &&
+        memcmp(layout->text, text, (size_t)len) == 0) {
+        return layout;
+    }
+
+    layout_format(layout, text, len, cols);
+    layout->hash = hash;
+    return layout;
+}
+
+void layout_format(Layout *layout, const char *text, int len, int cols) {
+    if (len >= LAYOUT_MAX_TEXT) len = LAYOUT_MAX_TEXT - 1;
+    if (cols < 1) cols = 1;
+
+    layout->hash = 0;
+    layout->cols = cols;
+    layout->text_len = len;
+    memcpy(layout->text, text, (size_t)len);
+    layout->text[len] = '\0';
+    layout_wrap(layout);
+}
+
+int layout_draw(const Layout *layout, int y, int x) {
+    for (int i = 0; i < layout->num_lines; i++) {
+        const LayoutLine *line = &layout->lines[i];
+        int col = x;
+        if (col == LAYOUT_CENTER) {
+            col = (layout->cols - line->width) / 2;
+            if (col < 0) col = 0;
+        }
+        mvaddnstr(y + i, col, layout->text + line->start, line->len);
+        if (layout->truncated && i == layout->num_lines - 1) addstr("...");
+    }
+    return layout->num_lines;
+}
+
+int screen_begin(Screen *screen, const void *data, size_t size) {
+    unsigned long key = hash_bytes(HASH_START, data, size);
+
+    if (screen->valid && screen->key == key && screen->cols == COLS && screen->lines == LINES &&
+        screen->data_size == size && memcmp(screen->data, data, size) == 0) {
+        return 1;
+    }
+
+    // Data too big to keep a copy of is never trusted, just formatted again
+    screen->key = key;
+    screen->cols = COLS;
+    screen->lines = LINES;
+    screen->valid = size <= SCREEN_MAX_DATA;
+    screen->data_size = size;
+    if (screen->valid) memcpy(screen->data, data, size);
+    screen->num_rows = 0;
+    return 0;
+}
+
+static void screen_add(Screen *screen, int y, int x, const char *format, va_list args) {
+    char buffer[LAYOUT_MAX_TEXT];
+
+    if (screen->num_rows >= SCREEN_MAX_ROWS) return;
+
+    int len = vsnprintf(buffer, sizeof(buffer), format, args);
+    if (len < 0) len = 0;
+    if (len >= LAYOUT_MAX_TEXT) len = LAYOUT_MAX_TEXT - 1;
+
+    int cols = x == LAYOUT_CENTER ? screen->cols : screen->cols - x;
+    screen->rows[screen->num_rows].y = y;
+    screen->rows[screen->num_rows].x = x;
+    screen->rows[screen->num_rows].layout = *layout_text(buffer, len, cols);
+    screen->num_rows++;
+}
+
+void screen_center(Screen *screen, int y, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    screen_add(screen, y, LAYOUT_CENTER, format, args);
+    va_end(args);
+}
+
+void screen_text(Screen *screen, int y, int x, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    screen_add(screen, y, x, format, args);
+    va_end(args);
+}
+
+void screen_draw(const Screen *screen) {
+    for (int i = 0; i < screen->num_rows; i++) {
+        layout_draw(&screen->rows[i].layout, screen->rows[i].y, screen->rows[i].x);
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <stddef.h>
+
+#define LAYOUT_MAX_TEXT 512  // Longest formatted string we lay out
+#define LAYOUT_MAX_LINES 8   // Wrapped lines kept per layout
+#define LAYOUT_CACHE_SIZE 64 // Cached layouts (direct mapped)
+#define SCREEN_MAX_ROWS 24   // Rows recorded per cached screen
+#define SCREEN_MAX_DATA 2048 // Bytes of data a screen keeps to check it is still valid
+#define LAYOUT_CENTER -1     // Column value meaning "center on the terminal"
+
+// One wrapped line: a byte span into Layout.text and its width on screen
+typedef struct {
+    unsigned short start;
+    unsigned short len;
+    unsigned short width;
+} LayoutLine;
+
+// A piece of text word-wrapped to a given terminal width
+typedef struct {
+    unsigned long hash;
+    int cols;
+    int text_len;
+    int num_lines;
+    int truncated; // More text than LAYOUT_MAX_LINES, the last line ends in "..."
+    char text[LAYOUT_MAX_TEXT];
+    LayoutLine lines[LAYOUT_MAX_LINES];
+} Layout;
+
+// A recorded screen: rows are only formatted again when the data behind
+// the screen or the terminal size changes
+typedef struct {
+    unsigned long key;
+    size_t data_size;
+    unsigned char data[SCREEN_MAX_DATA]; // Copy of the data, the hash alone can collide
+    int cols;
+    int lines;
+    int valid;
+    int num_rows;
+    struct {
+        int y;
+        int x; // LAYOUT_CENTER or a fixed column
+        Layout layout;
+    } rows[SCREEN_MAX_ROWS];
+} Screen;
+
+// Display width of a UTF-8 string in terminal columns
+int utf8_width(const char *text, int len);
+
+// Word-wraps text to cols columns, reusing a cached layout when possible.
+// The cache is shared, so callers must all be on one thread or hold the UI lock.
+const Layout *layout_text(const char *text, int len, int cols);
+
+// Word-wraps text into a layout the caller owns, for use off the cache
+void layout_format(Layout *layout, const char *text, int len, int cols);
+
+// Draws a layout starting at row y, returns the number of rows used
+int layout_draw(const Layout *layout, int y, int x);
+
+// Returns 1 if the screen is still valid for this data and terminal size,
+// otherwise clears it so the caller can record its rows again
+int screen_begin(Screen *screen, const void *data, size_t size);
+void screen_center(Screen *screen, int y, const char *format, ...);
+void screen_text(Screen *screen, int y, int x, const char *format, ...);
+void screen_draw(const Screen *screen);
+
+#endif
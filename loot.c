@@ -0,0 +1,133 @@
+#include <stdlib.h>
+#include <string.h>
+#include "loot.h"
+#include "rng.h"
+
+// Weights for rarity 1 (common) to 5 (legendary)
+static const int rarity_weights[6] = {0, 60, 25, 10, 4, 1};
+
+int loot_rarity_weight(int rarity) {
+    if (rarity < 1) rarity = 1;
+    if (rarity > 5) rarity = 5;
+    return rarity_weights[rarity];
+}
+
+void loot_init(LootTable *table, int drop_chance) {
+    memset(table, 0, sizeof(*table));
+    table->drop_chance = drop_chance;
+}
+
+void loot_free(LootTable *table) {
+    free(table->items);
+    free(table->threshold);
+    free(table->alias);
+    loot_init(table, table->drop_chance);
+}
+
+int loot_add(LootTable *table, const Item *item) {
+    if (table->num_items == table->capacity) {
+        int capacity = table->capacity ? table->capacity * 2 : 8;
+        Item *items = realloc(table->items, sizeof(Item) * capacity);
+        if (items == NULL) return 0;
+        table->items = items;
+        table->capacity = capacity;
+    }
+    table->items[table->num_items++] = *item;
+    return 1;
+}
+
+// Vose's alias method. Every column holds at most two entries: itself with
+// probability threshold / 2^32 and its alias otherwise.
+int loot_build(LootTable *table) {
+    int n = table->num_items;
+    uint64_t total = 0;
+
+    free(table->threshold);
+    free(table->alias);
+    table->threshold = malloc(sizeof(uint32_t) * (n ? n : 1));
+    table->alias = malloc(sizeof(uint32_t) * (n ? n : 1));
+    uint64_t *scaled = malloc(sizeof(uint64_t) * (n ? n : 1));
+    int *small = malloc(sizeof(int) * (n ? n : 1));
+    int *large = malloc(sizeof(int) * (n ? n : 1));
+
+    if (table->threshold == NULL || table->alias == NULL || scaled == NULL || small == NULL || large == NULL) {
+        free(scaled);
+        free(small);
+        free(large);
+        return 0;
+    }
+
+    for (int i = 0; i < n; i++) {
+        total += (uint64_t)loot_rarity_weight(table->items[i].rarity);
+    }
+
+    // Scale weights by n so the average column is exactly total
+    int num_small = 0, num_large = 0;
+    for (int i = 0; i < n; i++) {
+        scaled[i] = (uint64_t)loot_rarity_weight(table->items[i].rarity) * n;
+        table->alias[i] = (uint32_t)i;
+        if (scaled[i] < total) {
+            small[num_small++] = i;
+        } else {
+            large[num_large++] = i;
+        }
+    }
+
+    while (num_small > 0 && num_large > 0) {
+        int s = small[--num_small];
+        int l = large[--num_large];
+
+        table->threshold[s] = (uint32_t)((double)scaled[s] / (double)total * 4294967296.0);
+        table->alias[s] = (uint32_t)l;
+
+        // The large entry gives away what the small one was missing
+        scaled[l] = scaled[l] + scaled[s] - total;
+        if (scaled[l] < total) {
+            small[num_small++] = l;
+        } else {
+            large[num_large++] = l;
+        }
+    }
+
+    // Whatever is left is full up to rounding, it always keeps itself
+    while (num_large > 0) table->threshold[large[--num_large]] = UINT32_MAX;
+    while (num_small > 0) table->threshold[small[--num_small]] = UINT32_MAX;
+
+    free(scaled);
+    free(small);
+    free(large);
+    return 1;
+}
+
+int loot_sample(const LootTable *table, uint64_t *rng) {
+    uint64_t r = rng_next(rng);
+    uint32_t column = (uint32_t)(((r >> 32) * (uint64_t)table->num_items) >> 32);
+    return (uint32_t)r < table->threshold[column] ? (int)column : (int)table->alias[column];
+}
+
+void loot_sample_bulk(const LootTable *table, uint64_t *rng, int *out, int count) {
+    const uint32_t *threshold = table->threshold;
+    const uint32_t *alias = table->alias;
+    uint64_t n = (uint64_t)table->num_items;
+    uint64_t state = *rng;
+
+    for (int i = 0; i < count; i++) {
+        uint64_t r = rng_next(&state);
+        uint32_t column = (uint32_t)(((r >> 32) * n) >> 32);
+        out[i] = (uint32_t)r < threshold[column] ? (int)column : (int)alias[column];
+    }
+    *rng = state;
+}
+
+const Item *loot_roll(const LootTable *table, uint64_t *rng) {
+    if (table->num_items == 0) return NULL;
+    if ((int)((rng_next(rng) & 0xFFFFFFFFULL) * 100 >> 32) >= table->drop_chance) return NULL;
+    return &table->items[loot_sample(table, rng)];
+}
+
+const LootTable *loot_for_enemy(const EnemyLoot *loot, int count, const char *name) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(loot[i].enemy, name) == 0) return &loot[i].table;
+    }
+    return NULL;
+}
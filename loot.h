@@ -0,0 +1,49 @@
+#ifndef LOOT_H
+#define LOOT_H
+
+#include <stdint.h>
+#include "game.h"
+
+// A weighted list of items. Each entry's weight comes from its rarity, and
+// loot_build() turns the weights into an alias table so every draw costs
+// one random number and one comparison however many entries there are.
+typedef struct {
+    int num_items;
+    int capacity;
+    int drop_chance; // Percent chance that a roll drops anything at all
+    Item *items;
+    uint32_t *threshold; // Keep entry i if the low random bits are below this
+    uint32_t *alias;     // Otherwise take this entry
+} LootTable;
+
+// The loot table of one kind of enemy. Drops go by the enemy's name, so
+// a goblin drops goblin loot wherever it turns up.
+typedef struct {
+    char enemy[MAX_ENEMY_NAME_LEN];
+    LootTable table;
+} EnemyLoot;
+
+// Relative weight of an item of the given rarity (1-5)
+int loot_rarity_weight(int rarity);
+
+void loot_init(LootTable *table, int drop_chance);
+void loot_free(LootTable *table);
+
+// Adds a copy of item, returns 0 if out of memory. Call loot_build() after
+// the last add and before sampling.
+int loot_add(LootTable *table, const Item *item);
+int loot_build(LootTable *table);
+
+// Index of a weighted random entry, the table must not be empty
+int loot_sample(const LootTable *table, uint64_t *rng);
+
+// Fills out with count weighted random entry indices
+void loot_sample_bulk(const LootTable *table, uint64_t *rng, int *out, int count);
+
+// Applies drop_chance, returns the dropped item or NULL for nothing
+const Item *loot_roll(const LootTable *table, uint64_t *rng);
+
+// The table of enemies called name, NULL if they drop nothing
+const LootTable *loot_for_enemy(const EnemyLoot *loot, int count, const char *name);
+
+#endif
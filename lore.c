@@ -0,0 +1,318 @@
+#include <stdint.h>
+#include <string.h>
+#include "lore.h"
+#include "rng.h"
+
+#define LORE_MAX_RULES 32
+#define LORE_MAX_ALTS 256
+#define LORE_MAX_TOKENS 1024
+#define LORE_POOL_SIZE 8192
+#define LORE_MAX_DEPTH 8
+#define LORE_MAX_NAME_LEN 10
+#define LORE_ALPHABET 27 // Word boundary plus 'a'-'z'
+
+// Tokens are packed into 16 bits, the top two bits say what the rest is
+#define TOKEN_LITERAL 0x0000 // Offset into lore_pool
+#define TOKEN_RULE 0x4000    // Index into lore_rules
+#define TOKEN_NAME 0x8000    // A Markov generated proper name
+#define TOKEN_SUBJECT 0xC000 // The caller's subject
+#define TOKEN_KIND_MASK 0xC000
+#define TOKEN_VALUE_MASK 0x3FFF
+
+// Source grammar: alternatives are separated by '|', {rule} expands another
+// rule, {name} makes up a name and {subject} is what we are describing
+static const struct {
+    const char *name;
+    const char *body;
+} lore_grammar[] = {
+    {"location", "The {subject} of {name}, {loc_what}.|"
+                 "{subject} of {name}. {loc_story}.|"
+                 "A {adj} place the elders call {name}. {loc_story}.|"
+                 "{adj} and {adj}, {loc_what}."},
+    {"loc_what", "where {creatures} {verb} at {time}|"
+                 "once ruled by {title} {name}|"
+                 "{adj} since the {era}|"
+                 "where {title} {name} lost {treasure}"},
+    {"loc_story", "Travellers speak of {treasure} hidden {hide}|"
+                  "Few return from it after {time}|"
+                  "{title} {name} is said to be buried here|"
+                  "The {creatures} here remember the {era}"},
+    {"item", "The {subject} was {item_origin}. {item_trait}.|"
+             "{item_trait}. The {subject} was {item_origin}.|"
+             "A {adj} {subject}, {item_origin}."},
+    {"item_origin", "forged in {name} during the {era}|"
+                    "taken from {title} {name}|"
+                    "traded for {price} in {name}|"
+                    "dug up {hide}"},
+    {"item_trait", "It hums softly near {creatures}|"
+                   "It is warm to the touch|"
+                   "Runes on it spell {name}|"
+                   "It smells faintly of {smell}"},
+    {"enemy", "A {enemy_adj} {subject} {enemy_story}.|"
+              "{subject} of the {name} clan, {enemy_trait}.|"
+              "This {enemy_adj} {subject} is {enemy_trait}."},
+    {"enemy_story", "that has stalked these lands since the {era}|"
+                    "with a grudge against all travellers|"
+                    "guarding {treasure}|"
+                    "wearing trophies from {name}"},
+    {"enemy_trait", "feared for {enemy_habit}|"
+                    "exiled from {name} after the {era}|"
+                    "sworn to {title} {name}"},
+    {"enemy_habit", "its cruel laughter|stealing goats|biting first|hoarding shiny coins"},
+    {"enemy_adj", "scarred|hungry|one-eyed|grim|sly|towering|wretched"},
+    {"adj", "misty|quiet|ancient|windswept|cursed|forgotten|sunlit|silent"},
+    {"creatures", "wolves|ravens|trolls|spirits|smugglers|goats|elves"},
+    {"verb", "sing|gather|whisper|hunt|sleep|quarrel"},
+    {"time", "dusk|dawn|midnight|first frost|the turning of the tide"},
+    {"title", "Jarl|Queen|the hermit|the smith|Chieftain|old"},
+    {"era", "age of ash|long winter|first settlers|great flood|last war"},
+    {"treasure", "a silver horn|a chest of gold|a rune stone|the lost crown of {name}"},
+    {"hide", "beneath the roots|under the ice|behind the waterfall|in the deepest dark"},
+    {"smell", "pine|smoke|the sea|old blood|wet moss"},
+    {"price", "three goats|a longship|a silver coin|a song"},
+};
+
+#define LORE_NUM_GRAMMAR_RULES (int)(sizeof(lore_grammar) / sizeof(lore_grammar[0]))
+
+// Names the Markov chain learns letter patterns from
+static const char *lore_names[] = {
+    "asgard", "vanaheim", "hrafnsey", "ulfdalir", "skagafjord", "thingvellir",
+    "myrkvidur", "jotunheim", "bifrost", "svartalfheim", "eldborg", "kaldbakur",
+    "hvitserkur", "gullfoss", "dimmuborgir", "snaefell", "herdubreid", "askja",
+    "hekla", "katla", "vatnajokull", "glaumbaer", "borgarnes", "reykholt",
+    "hofsos", "hvalfjordur", "skalholt", "oddi", "haukadalur", "hlidarendi",
+    "bergthorshvoll", "grimsey", "flatey", "husavik", "akureyri", "isafjordur",
+};
+
+#define LORE_NUM_NAMES (int)(sizeof(lore_names) / sizeof(lore_names[0]))
+
+// Compiled grammar, everything lives in flat arrays built by lore_init()
+static char lore_pool[LORE_POOL_SIZE];
+static int lore_pool_used;
+static uint16_t lore_tokens[LORE_MAX_TOKENS];
+static uint16_t lore_token_len[LORE_MAX_TOKENS]; // Literal length, 0 for other tokens
+static int lore_num_tokens;
+static struct {
+    uint16_t first_token;
+    uint8_t num_tokens;
+} lore_alts[LORE_MAX_ALTS];
+static int lore_num_alts;
+static struct {
+    uint16_t first_alt;
+    uint8_t num_alts;
+} lore_rules[LORE_MAX_RULES];
+static int lore_kind_rule[LORE_NUM_KINDS];
+
+// Order-2 letter chain: cumulative next-letter counts per pair of letters
+static uint16_t lore_markov[LORE_ALPHABET * LORE_ALPHABET][LORE_ALPHABET];
+
+static int lore_ready = 0;
+
+// Uniform pick in [0, n) without a division
+static unsigned lore_pick(uint64_t *state, unsigned n) {
+    return (unsigned)(((rng_next(state) & 0xFFFFFFFFULL) * n) >> 32);
+}
+
+static int lore_find_rule(const char *name, int len) {
+    for (int i = 0; i < LORE_NUM_GRAMMAR_RULES; i++) {
+        if ((int)strlen(lore_grammar[i].name) == len && strncmp(lore_grammar[i].name, name, len) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void lore_add_token(uint16_t token, uint16_t len) {
+    if (lore_num_tokens >= LORE_MAX_TOKENS) return;
+    lore_tokens[lore_num_tokens] = token;
+    lore_token_len[lore_num_tokens] = len;
+    lore_num_tokens++;
+    lore_alts[lore_num_alts].num_tokens++;
+}
+
+static void lore_add_literal(const char *text, int len) {
+    if (len <= 0 || lore_pool_used + len > LORE_POOL_SIZE) return;
+    memcpy(lore_pool + lore_pool_used, text, len);
+    lore_add_token((uint16_t)(TOKEN_LITERAL | lore_pool_used), (uint16_t)len);
+    lore_pool_used += len;
+}
+
+static void lore_compile_rule(int rule) {
+    const char *p = lore_grammar[rule].body;
+
+    lore_rules[rule].first_alt = (uint16_t)lore_num_alts;
+    lore_rules[rule].num_alts = 0;
+
+    while (lore_num_alts < LORE_MAX_ALTS) {
+        lore_alts[lore_num_alts].first_token = (uint16_t)lore_num_tokens;
+        lore_alts[lore_num_alts].num_tokens = 0;
+
+        const char *literal = p;
+        while (*p != '\0' && *p != '|') {
+            if (*p == '{') {
+                const char *name = p + 1;
+                const char *end = strchr(name, '}');
+                if (end == NULL) break;
+
+                lore_add_literal(literal, (int)(p - literal));
+                if (end - name == 4 && strncmp(name, "name", 4) == 0) {
+                    lore_add_token(TOKEN_NAME, 0);
+                } else if (end - name == 7 && strncmp(name, "subject", 7) == 0) {
+                    lore_add_token(TOKEN_SUBJECT, 0);
+                } else {
+                    int ref = lore_find_rule(name, (int)(end - name));
+                    if (ref >= 0) lore_add_token((uint16_t)(TOKEN_RULE | ref), 0);
+                }
+                p = end + 1;
+                literal = p;
+            } else {
+                p++;
+            }
+        }
+        lore_add_literal(literal, (int)(p - literal));
+
+        lore_num_alts++;
+        lore_rules[rule].num_alts++;
+        if (*p != '|') break;
+        p++;
+    }
+}
+
+static int lore_letter(char c) {
+    return (c >= 'a' && c <= 'z') ? c - 'a' + 1 : 0;
+}
+
+static void lore_build_markov(void) {
+    memset(lore_markov, 0, sizeof(lore_markov));
+
+    for (int i = 0; i < LORE_NUM_NAMES; i++) {
+        int a = 0, b = 0;
+        for (const char *c = lore_names[i]; ; c++) {
+            int next = lore_letter(*c);
+            lore_markov[a * LORE_ALPHABET + b][next]++;
+            if (next == 0) break;
+            a = b;
+            b = next;
+        }
+    }
+
+    // Turn the counts into running totals so sampling is a single scan
+    for (int state = 0; state < LORE_ALPHABET * LORE_ALPHABET; state++) {
+        for (int next = 1; next < LORE_ALPHABET; next++) {
+            lore_markov[state][next] += lore_markov[state][next - 1];
+        }
+    }
+}
+
+void lore_init(void) {
+    if (lore_ready) return;
+
+    lore_pool_used = 0;
+    lore_num_tokens = 0;
+    lore_num_alts = 0;
+    for (int i = 0; i < LORE_NUM_GRAMMAR_RULES && i < LORE_MAX_RULES; i++) {
+        lore_compile_rule(i);
+    }
+
+    lore_kind_rule[LORE_LOCATION] = lore_find_rule("location", 8);
+    lore_kind_rule[LORE_ITEM] = lore_find_rule("item", 4);
+    lore_kind_rule[LORE_ENEMY] = lore_find_rule("enemy", 5);
+
+    lore_build_markov();
+    lore_ready = 1;
+}
+
+// Output cursor over the caller's buffer, no allocation anywhere
+typedef struct {
+    char *buffer;
+    int size;
+    int len;
+    int full;
+} LoreWriter;
+
+static void lore_write(LoreWriter *out, const char *text, int len) {
+    if (out->full) return;
+    if (out->len + len >= out->size) {
+        len = out->size - 1 - out->len;
+        out->full = 1;
+    }
+    memcpy(out->buffer + out->len, text, len);
+    out->len += len;
+}
+
+static void lore_write_name(LoreWriter *out, uint64_t *rng) {
+    char name[LORE_MAX_NAME_LEN];
+    int len = 0;
+    int a = 0, b = 0;
+    int restarts = 0;
+
+    while (len < LORE_MAX_NAME_LEN) {
+        const uint16_t *totals = lore_markov[a * LORE_ALPHABET + b];
+        unsigned total = totals[LORE_ALPHABET - 1];
+        if (total == 0) break;
+
+        unsigned r = lore_pick(rng, total);
+        int next = 0;
+        while (totals[next] <= r) next++;
+
+        if (next == 0) {
+            if (len >= 3 || ++restarts > 4) break;
+            // Too short to be a name, start over
+            len = a = b = 0;
+            continue;
+        }
+        name[len++] = (char)('a' + next - 1);
+        a = b;
+        b = next;
+    }
+
+    if (len > 0) name[0] = (char)(name[0] - 'a' + 'A');
+    lore_write(out, name, len);
+}
+
+static void lore_expand(LoreWriter *out, int rule, const char *subject, uint64_t *rng, int depth) {
+    if (depth > LORE_MAX_DEPTH || out->full) return;
+
+    int alt = lore_rules[rule].first_alt + lore_pick(rng, lore_rules[rule].num_alts);
+    int first = lore_alts[alt].first_token;
+    int last = first + lore_alts[alt].num_tokens;
+
+    for (int i = first; i < last; i++) {
+        uint16_t token = lore_tokens[i];
+        switch (token & TOKEN_KIND_MASK) {
+            case TOKEN_LITERAL:
+                lore_write(out, lore_pool + (token & TOKEN_VALUE_MASK), lore_token_len[i]);
+                break;
+            case TOKEN_RULE:
+                lore_expand(out, token & TOKEN_VALUE_MASK, subject, rng, depth + 1);
+                break;
+            case TOKEN_NAME:
+                lore_write_name(out, rng);
+                break;
+            case TOKEN_SUBJECT:
+                lore_write(out, subject, (int)strlen(subject));
+                break;
+        }
+    }
+}
+
+int lore_generate(LoreKind kind, const char *subject, unsigned long seed, char *buffer, int size) {
+    if (size <= 0) return 0;
+    buffer[0] = '\0';
+    if (!lore_ready || kind < 0 || kind >= LORE_NUM_KINDS || lore_kind_rule[kind] < 0) return 0;
+
+    LoreWriter out = {buffer, size, 0, 0};
+    uint64_t rng = ((uint64_t)seed << 2) ^ (uint64_t)kind;
+
+    lore_expand(&out, lore_kind_rule[kind], subject != NULL ? subject : "", &rng, 0);
+
+    // Cut at the last whole word if we ran out of room
+    if (out.full) {
+        while (out.len > 0 && buffer[out.len - 1] != ' ') out.len--;
+        while (out.len > 0 && (buffer[out.len - 1] == ' ' || buffer[out.len - 1] == ',')) out.len--;
+    }
+    buffer[out.len] = '\0';
+
+    if (buffer[0] >= 'a' && buffer[0] <= 'z') buffer[0] = (char)(buffer[0] - 'a' + 'A');
+    return out.len;
+}
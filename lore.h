@@ -0,0 +1,21 @@
+#ifndef LORE_H
+#define LORE_H
+
+// What the lore is about, each kind has its own top level grammar rule
+typedef enum {
+    LORE_LOCATION,
+    LORE_ITEM,
+    LORE_ENEMY,
+    LORE_NUM_KINDS
+} LoreKind;
+
+// Builds the grammar and name tables, call once before generating
+void lore_init(void);
+
+// Writes a description into buffer (always NUL terminated, cut at a word
+// boundary if it does not fit). The same kind, subject and seed always give
+// the same text. subject is what {subject} expands to, e.g. "Forest".
+// Returns the number of characters written.
+int lore_generate(LoreKind kind, const char *subject, unsigned long seed, char *buffer, int size);
+
+#endif
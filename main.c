@@ -1,108 +1,120 @@
 #include <ncurses.h>
+#include <locale.h> // For UTF-8 names
+#include <stdarg.h>
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h> // For random item generation
 #include <time.h>   // For random seed
+#include "game.h"
+#include "balance.h"
+#include "bot.h"
+#include "initiative.h"
+#include "layout.h"
+#include "lore.h"
+#include "loot.h"
+#include "render.h"
+#include "rules.h"
+#include "vm.h"
+#include "save.h"
+#include "quest.h"
 
-#define MAX_NAME_LEN 50
-#define MAX_INVENTORY_SIZE 10
-#define MAX_ITEM_NAME_LEN 20
-#define NUM_LOCATIONS 3
-#define MAX_ENEMY_NAME_LEN 30
-#define MAX_LOCATION_NAME_LEN 30
-
-// Item types
-typedef enum {
-    ITEM_TYPE_WEAPON,
-    ITEM_TYPE_ARMOR,
-    ITEM_TYPE_CONSUMABLE,
-    ITEM_TYPE_QUEST
-} ItemType;
-
-// Item structure
-typedef struct {
-    char name[MAX_ITEM_NAME_LEN];
-    char description[100];
-    ItemType type;
-    int value; // Could be attack bonus, defense bonus, or healing amount
-    int rarity; // 1-5 scale (5 being rarest)
-} Item;
-
-// Enemy structure
+// Who is still standing in a fight, kept up to date as enemies fall so
+// nothing has to scan the enemy list every turn
 typedef struct {
-    char name[MAX_ENEMY_NAME_LEN];
-    int health;
-    int max_health;
-    int attack;
-    int defense;
-    int exp_reward;
-    int gold_reward;
-} Enemy;
-
-// Stats structure
-typedef struct {
-    int strength;
-    int intelligence;
-    int agility;
-    int health;
-    int max_health;
-    int mana;
-    int max_mana;
-    int experience;
-    int level;
-    int defense;
-} Stats;
-
-// Adventurer structure
-typedef struct {
-    char name[MAX_NAME_LEN];
-    Stats stats;
-    Item inventory[MAX_INVENTORY_SIZE];
-    int num_items;
-    int current_location;
-    int gold;
-} Adventurer;
-
-// Location structure
-typedef struct {
-    char name[MAX_LOCATION_NAME_LEN];
-    char description[100];
-    int has_enemy;
-    Enemy enemy;
-    int num_items;
-    Item items[5]; // Max 5 items per location
-} Location;
+    Enemy *enemies;
+    int num_enemies;
+    int living;      // Enemies still standing
+    int first_alive; // Index of the first of them, who the player attacks
+    int defeated;    // Enemies felled in this fight
+} Battle;
 
 // Function declarations
 void init_ncurses();
-void print_center(int y, const char *format, ...);
+int print_center(int y, const char *format, ...);
 void draw_background(const Adventurer *adv, const Location *locations);
 void get_input(const char *prompt, char *buffer, int max_len);
 void display_status_line(const Adventurer *adv, const Location *locations);
 void register_adventurer(Adventurer *adv);
 void move_to_location(Adventurer *adv, int new_location, const Location *locations);
-void main_game_loop(Adventurer *adv, const Location *locations);
+void main_game_loop(Adventurer *adv, Location *locations);
 void create_character(Adventurer *adv);
 void display_character_sheet(const Adventurer *adv);
-void add_item_to_inventory(Adventurer *adv, const Item *item);
+int add_item_to_inventory(Adventurer *adv, const Item *item);
 int has_item(const Adventurer *adv, const char *item_name);
 void use_item(Adventurer *adv, const char *item_name);
 void display_inventory(const Adventurer *adv);
 void generate_world(Location *locations);
-void generate_location_items(Location *location);
-void generate_enemy(Location *location);
+const Item *find_catalog_item(const char *item_name);
+void add_catalog_loot(LootTable *table, const char *item_name);
+void add_location_item(Location *location, const char *item_name);
+void generate_loot_tables(const Location *locations);
+void generate_location_items(Location *location, const LootTable *loot, unsigned long seed);
+void describe_item(Item *item, unsigned long seed);
+void add_enemy(Location *location, const Enemy *enemy);
+void generate_enemies(Location *location);
+void refresh_enemies(Location *locations);
 void display_location_info(const Location *location);
-void encounter_enemy(Adventurer *adv, const Location *location);
-void display_combat_menu(const Adventurer *adv, const Enemy *enemy);
-void combat_round(Adventurer *adv, Enemy *enemy);
+void encounter_enemy(Adventurer *adv, Location *location);
+void display_combat_menu(const Adventurer *adv, const Enemy *enemies, int num_enemies);
+int living_enemies(const Enemy *enemies, int num_enemies);
+void defeat_enemy(Adventurer *adv, Enemy *enemy);
+void remove_enemy(Battle *battle, InitiativeQueue *queue, int index);
+void combat_round(Adventurer *adv, Battle *battle, InitiativeQueue *queue, int player_attacks);
 void gain_experience(Adventurer *adv, int exp_gained);
 void level_up(Adventurer *adv);
 void display_location_menu(const Location *location);
-int calculate_damage(int attack, int defense);
+void display_message_log(void);
+void display_quest_log(void);
+void generate_quests(void);
+void quest_progress(Adventurer *adv, QuestTrigger trigger, const char *target);
+int bot_key(const Adventurer *adv, int in_encounter);
+int bot_prepare(const Location *locations);
 
 // Global game state
 int game_running = 1;
 
+// Loot tables, indexed like the locations array
+LootTable location_loot[NUM_LOCATIONS];
+
+// What each kind of enemy drops, wherever it is met
+#define NUM_ENEMY_LOOT 2
+EnemyLoot enemy_loot[NUM_ENEMY_LOOT];
+uint64_t loot_rng;
+
+// Quests and what their objectives are waiting on
+QuestLog quest_log;
+
+// Who is playing, see --bot
+typedef enum {
+    PLAYER_HUMAN,
+    PLAYER_GREEDY_BOT,
+    PLAYER_MCTS_BOT
+} PlayerType;
+
+PlayerType player_type = PLAYER_HUMAN;
+BotWorld bot_world;
+const Location *bot_locations;
+uint64_t bot_rng;
+int bot_turns;
+double bot_think_seconds;
+
+// Every item that can turn up as loot
+const Item item_catalog[] = {
+    {"Health Potion", "Restores 30 HP", ITEM_TYPE_CONSUMABLE, 30, 2},
+    {"Iron Sword", "A sturdy sword", ITEM_TYPE_WEAPON, 5, 3},
+    {"Ancient Sword", "A sword from ancient times", ITEM_TYPE_WEAPON, 10, 4},
+    {"Runed Axe", "An axe covered in glowing runes", ITEM_TYPE_WEAPON, 14, 5},
+    {"Leather Armor", "Scuffed but sturdy", ITEM_TYPE_ARMOR, 3, 2},
+    {"Goblin Ear", "Proof of a slain goblin", ITEM_TYPE_QUEST, 0, 1},
+    {"Orc Tusk", "A cracked yellow tusk", ITEM_TYPE_QUEST, 0, 2},
+    {"Forest Moss", "A mysterious green moss", ITEM_TYPE_QUEST, 0, 1},
+    {"Gold Coin", "A shiny gold coin", ITEM_TYPE_QUEST, 0, 1},
+};
+
+#define NUM_CATALOG_ITEMS (int)(sizeof(item_catalog) / sizeof(item_catalog[0]))
+
 void init_ncurses() {
+    setlocale(LC_ALL, ""); // Let ncurses handle multibyte text
     initscr();  // Initialize NCurses
     cbreak();   // Line buffering disabled
     noecho();   // Don't echo characters
@@ -111,18 +123,19 @@ void init_ncurses() {
     timeout(0); // Non-blocking getch
 }
 
-void print_center(int y, const char *format, ...) {
+// Prints centered, word-wrapped text starting at row y, returns rows used.
+// At most LAYOUT_MAX_LINES rows, text past that is cut with "...".
+int print_center(int y, const char *format, ...) {
     va_list args;
     va_start(args, format);
 
-    char buffer[100]; // Assuming a maximum buffer size of 100 characters
-
-    vsnprintf(buffer, sizeof(buffer), format, args);
-    int x = (COLS - strlen(buffer)) / 2;
-
-    mvprintw(y, x, "%s", buffer);
+    char buffer[LAYOUT_MAX_TEXT];
+    int len = vsnprintf(buffer, sizeof(buffer), format, args);
+    if (len < 0) len = 0;
 
     va_end(args);
+
+    return layout_draw(layout_text(buffer, len, COLS), y, LAYOUT_CENTER);
 }
 
 void draw_background(const Adventurer *adv, const Location *locations) {
@@ -164,11 +177,15 @@ void create_character(Adventurer *adv) {
     print_center(3, "What is your adventurer name?:");
     refresh();
     
-    echo(); // Enable echoing of characters
-    curs_set(1); // Show cursor
-    mvgetnstr(4, 10, player_name, MAX_NAME_LEN);
-    curs_set(0); // Hide cursor
-    noecho(); // Disable echoing of characters
+    if (player_type != PLAYER_HUMAN) {
+        strcpy(player_name, "Bot");
+    } else {
+        echo(); // Enable echoing of characters
+        curs_set(1); // Show cursor
+        mvgetnstr(4, 10, player_name, MAX_NAME_LEN);
+        curs_set(0); // Hide cursor
+        noecho(); // Disable echoing of characters
+    }
 
     // Copy player name to adventurer struct
     strncpy(adv->name, player_name, MAX_NAME_LEN - 1);
@@ -185,8 +202,12 @@ void create_character(Adventurer *adv) {
 
     // Get creation method
     int ch;
-    while ((ch = getch()) != '1' && ch != '2') {
-        // Wait for valid input
+    if (player_type != PLAYER_HUMAN) {
+        ch = '2'; // Bots always quick create
+    } else {
+        while ((ch = getch()) != '1' && ch != '2') {
+            // Wait for valid input
+        }
     }
     
     if (ch == '2') {
@@ -206,42 +227,25 @@ void create_character(Adventurer *adv) {
         refresh();
 
         // Get class choice for quick creation
-        while ((ch = getch()) != '1' && ch != '2' && ch != '3') {
-            // Wait for valid input
+        if (player_type != PLAYER_HUMAN) {
+            ch = '1' + rand() % 3; // Bots cover every class
+        } else {
+            while ((ch = getch()) != '1' && ch != '2' && ch != '3') {
+                // Wait for valid input
+            }
         }
         
         class_choice = ch - '0';
 
-        // Initialize stats based on class choice with quick distribution
-        switch (class_choice) {
-            case 1: // Warrior - more strength and health
-                adv->stats.strength = 20;
-                adv->stats.intelligence = 10;
-                adv->stats.agility = 12;
-                adv->stats.max_health = 130;
-                adv->stats.health = 130;
-                adv->stats.max_mana = 35;
-                adv->stats.mana = 35;
-                break;
-            case 2: // Mage - more intelligence and mana
-                adv->stats.strength = 10;
-                adv->stats.intelligence = 20;
-                adv->stats.agility = 12;
-                adv->stats.max_health = 75;
-                adv->stats.health = 75;
-                adv->stats.max_mana = 90;
-                adv->stats.mana = 90;
-                break;
-            case 3: // Rogue - balanced stats
-                adv->stats.strength = 15;
-                adv->stats.intelligence = 15;
-                adv->stats.agility = 20;
-                adv->stats.max_health = 95;
-                adv->stats.health = 95;
-                adv->stats.max_mana = 55;
-                adv->stats.mana = 55;
-                break;
-        }
+        // Initialize stats from the class presets in the balance tables
+        const ClassPreset *preset = &balance_current()->classes[class_choice - 1];
+        adv->stats.strength = preset->strength;
+        adv->stats.intelligence = preset->intelligence;
+        adv->stats.agility = preset->agility;
+        adv->stats.max_health = preset->health;
+        adv->stats.health = preset->health;
+        adv->stats.max_mana = preset->mana;
+        adv->stats.mana = preset->mana;
     } else {
         // Manual distribution - initialize to zero and let player distribute
         strength = 0;
@@ -325,6 +329,7 @@ void create_character(Adventurer *adv) {
     }
 
     adv->stats.level = 1;
+    adv->stats.defense = 0;
     adv->stats.experience = 0;
     adv->gold = 50;
     adv->num_items = 0;
@@ -337,30 +342,45 @@ void create_character(Adventurer *adv) {
 
 void move_to_location(Adventurer *adv, int new_location, const Location *locations) {
     adv->current_location = new_location;
-    clear();
-    print_center(LINES / 2, "You have moved to %s.", locations[adv->current_location].name);
-    refresh();
-    getch(); // Wait for a key press
+    render_scene("");
+    render_scene_line("You have moved to %s.", locations[adv->current_location].name);
+
+    // Scripted event for arriving here, if the content defines one
+    int healed = rules_enter_location(&adv->stats, &adv->gold, locations[new_location].name,
+                                      (uint64_t)rand());
+    if (healed > 0) {
+        render_event(EVENT_HEALED, adv->name, locations[new_location].name, healed, 0);
+    }
 }
 
 void display_character_sheet(const Adventurer *adv) {
+    static Screen sheet;
+
+    // Only format the sheet again when the adventurer or terminal changed
+    if (!screen_begin(&sheet, adv, sizeof(*adv))) {
+        screen_center(&sheet, 1, "~~~ Character Sheet ~~~");
+        screen_center(&sheet, 3, "Name: %s", adv->name);
+        screen_center(&sheet, 4, "Level: %d", adv->stats.level);
+        screen_center(&sheet, 5, "Health: %d/%d", adv->stats.health, adv->stats.max_health);
+        screen_center(&sheet, 6, "Mana: %d/%d", adv->stats.mana, adv->stats.max_mana);
+        screen_center(&sheet, 7, "Gold: %d", adv->gold);
+        screen_center(&sheet, 9, "Strength: %d", adv->stats.strength);
+        screen_center(&sheet, 10, "Intelligence: %d", adv->stats.intelligence);
+        screen_center(&sheet, 11, "Agility: %d", adv->stats.agility);
+        screen_center(&sheet, 13, "Experience: %d", adv->stats.experience);
+        screen_center(&sheet, 15, "Press any key to continue...");
+    }
+
+    if (!ui_trylock()) return; // The render thread is drawing, skip it
     clear();
-    print_center(1, "~~~ Character Sheet ~~~");
-    print_center(3, "Name: %s", adv->name);
-    print_center(4, "Level: %d", adv->stats.level);
-    print_center(5, "Health: %d/%d", adv->stats.health, adv->stats.max_health);
-    print_center(6, "Mana: %d/%d", adv->stats.mana, adv->stats.max_mana);
-    print_center(7, "Gold: %d", adv->gold);
-    print_center(9, "Strength: %d", adv->stats.strength);
-    print_center(10, "Intelligence: %d", adv->stats.intelligence);
-    print_center(11, "Agility: %d", adv->stats.agility);
-    print_center(13, "Experience: %d", adv->stats.experience);
-    print_center(15, "Press any key to continue...");
+    screen_draw(&sheet);
     refresh();
     getch(); // Wait for a key press to continue
+    ui_unlock();
 }
 
 void display_inventory(const Adventurer *adv) {
+    if (!ui_trylock()) return; // The render thread is drawing, skip it
     clear();
     print_center(1, "~~~ Inventory ~~~");
     
@@ -372,23 +392,31 @@ void display_inventory(const Adventurer *adv) {
                      adv->inventory[i].type == ITEM_TYPE_WEAPON ? "Weapon" :
                      adv->inventory[i].type == ITEM_TYPE_ARMOR ? "Armor" :
                      adv->inventory[i].type == ITEM_TYPE_CONSUMABLE ? "Consumable" : "Quest");
+
+            // The lore goes after the name, as much of it as fits
+            int y, x;
+            getyx(stdscr, y, x);
+            if (x + 3 < COLS) mvaddnstr(y, x + 2, adv->inventory[i].description, COLS - x - 3);
         }
     }
     
     print_center(LINES - 2, "Press any key to continue...");
     refresh();
     getch(); // Wait for a key press
+    ui_unlock();
 }
 
-void add_item_to_inventory(Adventurer *adv, const Item *item) {
-    if (adv->num_items < MAX_INVENTORY_SIZE) {
-        strcpy(adv->inventory[adv->num_items].name, item->name);
-        strcpy(adv->inventory[adv->num_items].description, item->description);
-        adv->inventory[adv->num_items].type = item->type;
-        adv->inventory[adv->num_items].value = item->value;
-        adv->inventory[adv->num_items].rarity = item->rarity;
-        adv->num_items++;
-    }
+// Returns 0 if the pack is full and the item was left behind
+int add_item_to_inventory(Adventurer *adv, const Item *item) {
+    if (adv->num_items >= MAX_INVENTORY_SIZE) return 0;
+
+    strcpy(adv->inventory[adv->num_items].name, item->name);
+    strcpy(adv->inventory[adv->num_items].description, item->description);
+    adv->inventory[adv->num_items].type = item->type;
+    adv->inventory[adv->num_items].value = item->value;
+    adv->inventory[adv->num_items].rarity = item->rarity;
+    adv->num_items++;
+    return 1;
 }
 
 int has_item(const Adventurer *adv, const char *item_name) {
@@ -404,19 +432,11 @@ void use_item(Adventurer *adv, const char *item_name) {
     for (int i = 0; i < adv->num_items; i++) {
         if (strcmp(adv->inventory[i].name, item_name) == 0) {
             if (adv->inventory[i].type == ITEM_TYPE_CONSUMABLE) {
+                Item item = adv->inventory[i];
+
                 // Apply item effect
-                if (strcmp(adv->inventory[i].name, "Health Potion") == 0) {
-                    int heal_amount = 30;
-                    adv->stats.health += heal_amount;
-                    if (adv->stats.health > adv->stats.max_health) {
-                        adv->stats.health = adv->stats.max_health;
-                    }
-                    clear();
-                    print_center(1, "You used a Health Potion and recovered %d HP!", heal_amount);
-                    print_center(3, "Press any key to continue...");
-                    refresh();
-                    getch();
-                }
+                int amount = rules_use_consumable(&adv->stats, &adv->gold, &item, (uint64_t)rand());
+                render_event(EVENT_ITEM_USED, adv->name, item.name, amount, 0);
                 
                 // Remove item from inventory
                 for (int j = i; j < adv->num_items - 1; j++) {
@@ -429,156 +449,263 @@ void use_item(Adventurer *adv, const char *item_name) {
     }
 }
 
-void generate_location_items(Location *location) {
+const Item *find_catalog_item(const char *item_name) {
+    for (int i = 0; i < NUM_CATALOG_ITEMS; i++) {
+        if (strcmp(item_catalog[i].name, item_name) == 0) return &item_catalog[i];
+    }
+    return NULL;
+}
+
+void add_catalog_loot(LootTable *table, const char *item_name) {
+    const Item *item = find_catalog_item(item_name);
+    if (item != NULL) loot_add(table, item);
+}
+
+void add_location_item(Location *location, const char *item_name) {
+    const Item *item = find_catalog_item(item_name);
+    if (item != NULL && location->num_items < MAX_LOCATION_ITEMS) {
+        location->items[location->num_items++] = *item;
+    }
+}
+
+void generate_loot_tables(const Location *locations) {
+    for (int i = 0; i < NUM_LOCATIONS; i++) {
+        loot_init(&location_loot[i], 50); // 50% chance of a random find
+
+        if (strcmp(locations[i].name, "Town") == 0) {
+            add_catalog_loot(&location_loot[i], "Health Potion");
+            add_catalog_loot(&location_loot[i], "Leather Armor");
+        } else if (strcmp(locations[i].name, "Forest") == 0) {
+            add_catalog_loot(&location_loot[i], "Health Potion");
+            add_catalog_loot(&location_loot[i], "Leather Armor");
+            add_catalog_loot(&location_loot[i], "Iron Sword");
+        } else if (strcmp(locations[i].name, "Cave") == 0) {
+            add_catalog_loot(&location_loot[i], "Health Potion");
+            add_catalog_loot(&location_loot[i], "Ancient Sword");
+            add_catalog_loot(&location_loot[i], "Runed Axe");
+        }
+
+        loot_build(&location_loot[i]);
+    }
+
+    // 75% chance an enemy drops something
+    for (int i = 0; i < NUM_ENEMY_LOOT; i++) {
+        loot_init(&enemy_loot[i].table, 75);
+    }
+
+    strcpy(enemy_loot[0].enemy, "Goblin");
+    add_catalog_loot(&enemy_loot[0].table, "Goblin Ear");
+    add_catalog_loot(&enemy_loot[0].table, "Health Potion");
+    add_catalog_loot(&enemy_loot[0].table, "Leather Armor");
+
+    strcpy(enemy_loot[1].enemy, "Orc");
+    add_catalog_loot(&enemy_loot[1].table, "Orc Tusk");
+    add_catalog_loot(&enemy_loot[1].table, "Health Potion");
+    add_catalog_loot(&enemy_loot[1].table, "Ancient Sword");
+    add_catalog_loot(&enemy_loot[1].table, "Runed Axe");
+
+    for (int i = 0; i < NUM_ENEMY_LOOT; i++) {
+        loot_build(&enemy_loot[i].table);
+    }
+}
+
+void generate_location_items(Location *location, const LootTable *loot, unsigned long seed) {
     // Add some items to locations
     location->num_items = 0;
     
     // Add some standard items to the first location (Town)
     if (strcmp(location->name, "Town") == 0) {
-        Item item1;
-        strcpy(item1.name, "Health Potion");
-        strcpy(item1.description, "Restores 30 HP");
-        item1.type = ITEM_TYPE_CONSUMABLE;
-        item1.value = 30;
-        item1.rarity = 2;
-        location->items[location->num_items++] = item1;
-        
-        Item item2;
-        strcpy(item2.name, "Iron Sword");
-        strcpy(item2.description, "A sturdy sword");
-        item2.type = ITEM_TYPE_WEAPON;
-        item2.value = 5;
-        item2.rarity = 3;
-        location->items[location->num_items++] = item2;
+        add_location_item(location, "Health Potion");
+        add_location_item(location, "Iron Sword");
     }
     // Add items to Forest
     else if (strcmp(location->name, "Forest") == 0) {
-        Item item1;
-        strcpy(item1.name, "Health Potion");
-        strcpy(item1.description, "Restores 30 HP");
-        item1.type = ITEM_TYPE_CONSUMABLE;
-        item1.value = 30;
-        item1.rarity = 2;
-        location->items[location->num_items++] = item1;
-        
-        Item item2;
-        strcpy(item2.name, "Forest Moss");
-        strcpy(item2.description, "A mysterious green moss");
-        item2.type = ITEM_TYPE_QUEST;
-        item2.value = 0;
-        item2.rarity = 1;
-        location->items[location->num_items++] = item2;
+        add_location_item(location, "Health Potion");
+        add_location_item(location, "Forest Moss");
     }
     // Add items to Cave
     else if (strcmp(location->name, "Cave") == 0) {
-        Item item1;
-        strcpy(item1.name, "Gold Coin");
-        strcpy(item1.description, "A shiny gold coin");
-        item1.type = ITEM_TYPE_QUEST;
-        item1.value = 0;
-        item1.rarity = 1;
-        location->items[location->num_items++] = item1;
-        
-        Item item2;
-        strcpy(item2.name, "Ancient Sword");
-        strcpy(item2.description, "A sword from ancient times");
-        item2.type = ITEM_TYPE_WEAPON;
-        item2.value = 10;
-        item2.rarity = 4;
-        location->items[location->num_items++] = item2;
+        add_location_item(location, "Gold Coin");
+        add_location_item(location, "Ancient Sword");
+    }
+
+    // Maybe a random find from the location's loot table
+    const Item *found = loot_roll(loot, &loot_rng);
+    if (found != NULL && location->num_items < MAX_LOCATION_ITEMS) {
+        location->items[location->num_items++] = *found;
     }
+
+    for (int i = 0; i < location->num_items; i++) {
+        describe_item(&location->items[i], seed + i);
+    }
+}
+
+// Gives an item found in the world its own lore
+void describe_item(Item *item, unsigned long seed) {
+    lore_generate(LORE_ITEM, item->name, seed, item->description, sizeof(item->description));
 }
 
-void generate_enemy(Location *location) {
-    // Set that this location has an enemy
+void add_enemy(Location *location, const Enemy *enemy) {
+    if (enemy == NULL || location->num_enemies >= MAX_LOCATION_ENEMIES) return;
+
+    Enemy *added = &location->enemies[location->num_enemies++];
+    *added = *enemy;
+    lore_generate(LORE_ENEMY, added->name, (unsigned long)rand(),
+                  added->description, sizeof(added->description));
     location->has_enemy = 1;
-    
-    // Create enemy based on location type
+}
+
+void generate_enemies(Location *location) {
+    // Enemy stats come from the balance tables
+    const Balance *balance = balance_current();
+    const Enemy *goblin = balance_enemy(balance, "Goblin");
+    const Enemy *orc = balance_enemy(balance, "Orc");
+
+    location->has_enemy = 0;
+    location->num_enemies = 0;
+
+    // Create enemies based on location type
     if (strcmp(location->name, "Forest") == 0) {
-        strcpy(location->enemy.name, "Goblin");
-        location->enemy.health = 40;
-        location->enemy.max_health = 40;
-        location->enemy.attack = 8;
-        location->enemy.defense = 2;
-        location->enemy.exp_reward = 25;
-        location->enemy.gold_reward = 10;
+        // Goblins come in packs of one or two
+        add_enemy(location, goblin);
+        if (rand() % 2) add_enemy(location, goblin);
     } else if (strcmp(location->name, "Cave") == 0) {
-        strcpy(location->enemy.name, "Orc");
-        location->enemy.health = 60;
-        location->enemy.max_health = 60;
-        location->enemy.attack = 12;
-        location->enemy.defense = 4;
-        location->enemy.exp_reward = 40;
-        location->enemy.gold_reward = 20;
-    } else {
-        // Town has no enemy
-        location->has_enemy = 0;
+        // An orc, sometimes with a goblin running errands for it
+        add_enemy(location, orc);
+        if (rand() % 2) add_enemy(location, goblin);
     }
+    // Town has no enemies
 }
 
-void display_location_info(const Location *location) {
-    clear();
-    print_center(1, "~~~ %s ~~~", location->name);
-    print_center(3, "%s", location->description);
-    
-    if (location->num_items > 0) {
-        print_center(5, "Items here:");
-        for (int i = 0; i < location->num_items; i++) {
-            mvprintw(6 + i, 5, "- %s", location->items[i].name);
+// Brings enemies already out in the world in line with new balance tables,
+// keeping how hurt they are
+void refresh_enemies(Location *locations) {
+    const Balance *balance = balance_current();
+
+    for (int i = 0; i < NUM_LOCATIONS; i++) {
+        for (int j = 0; j < locations[i].num_enemies; j++) {
+            Enemy *enemy = &locations[i].enemies[j];
+            const Enemy *template = balance_enemy(balance, enemy->name);
+            if (template == NULL) continue;
+
+            if (enemy->health > 0) {
+                enemy->health = enemy->health * template->max_health / enemy->max_health;
+                if (enemy->health < 1) enemy->health = 1;
+            }
+            enemy->max_health = template->max_health;
+            enemy->attack = template->attack;
+            enemy->defense = template->defense;
+            enemy->exp_reward = template->exp_reward;
+            enemy->gold_reward = template->gold_reward;
+            enemy->agility = template->agility;
         }
     }
-    
-    if (location->has_enemy) {
-        print_center(10, "You hear a menacing presence...");
+}
+
+void display_location_info(const Location *location) {
+    static Screen info;
+
+    if (!screen_begin(&info, location, sizeof(*location))) {
+        screen_center(&info, 1, "~~~ %s ~~~", location->name);
+        screen_center(&info, 3, "%s", location->description);
+
+        if (location->num_items > 0) {
+            screen_center(&info, 5, "Items here:");
+            for (int i = 0; i < location->num_items; i++) {
+                screen_text(&info, 6 + i, 5, "- %s", location->items[i].name);
+            }
+        }
+
+        if (location->has_enemy) {
+            screen_center(&info, 10, "You hear a menacing presence...");
+        }
+
+        screen_center(&info, LINES - 2, "Press any key to continue...");
     }
-    
-    print_center(LINES - 2, "Press any key to continue...");
+
+    if (!ui_trylock()) return; // The render thread is drawing, skip it
+    clear();
+    screen_draw(&info);
     refresh();
     getch(); // Wait for a key press
+    ui_unlock();
 }
 
-void encounter_enemy(Adventurer *adv, const Location *location) {
-    if (!location->has_enemy) return;
-    
-    Enemy *enemy = &location->enemy;
-    
-    clear();
-    print_center(1, "~~~ Combat! ~~~");
-    print_center(3, "A wild %s appears!", enemy->name);
-    print_center(5, "HP: %d/%d", enemy->health, enemy->max_health);
-    print_center(7, "What will you do?");
-    print_center(9, "1. Fight");
-    print_center(10, "2. Run Away");
-    refresh();
+void encounter_enemy(Adventurer *adv, Location *location) {
+    Enemy *enemies = location->enemies;
+    int num_enemies = location->num_enemies;
+
+    if (!location->has_enemy || living_enemies(enemies, num_enemies) == 0) return;
     
-    int ch = getch();
+    // The render thread draws the scene, only the key press is read here
+    render_scene("~~~ Combat! ~~~");
+    for (int i = 0; i < num_enemies; i++) {
+        if (enemies[i].health <= 0) continue;
+        render_scene_line("A wild %s appears! (HP: %d/%d)", enemies[i].name, enemies[i].health, enemies[i].max_health);
+        render_scene_line("%s", enemies[i].description);
+    }
+    render_scene_line("");
+    render_scene_line("What will you do?");
+    render_scene_line("1. Fight    2. Run Away");
+
+    int ch = ERR;
+    if (ui_trylock()) {
+        ch = getch();
+        ui_unlock();
+    }
+    if (player_type != PLAYER_HUMAN) ch = bot_key(adv, 1);
+
+    // Turn order: combatant 0 is the player, enemy i is combatant i + 1
+    InitiativeQueue queue;
+    if (!initiative_init(&queue, num_enemies + 1)) return;
+    initiative_add(&queue, 0, adv->stats.agility);
+    for (int i = 0; i < num_enemies; i++) {
+        if (enemies[i].health > 0) initiative_add(&queue, i + 1, enemies[i].agility);
+    }
+
+    Battle battle = {enemies, num_enemies, living_enemies(enemies, num_enemies), 0, 0};
+    while (enemies[battle.first_alive].health <= 0) battle.first_alive++;
+    const Enemy *first_foe = &enemies[battle.first_alive];
+
     if (ch == '1') {
+        int total_exp = 0, total_gold = 0;
+        for (int i = 0; i < num_enemies; i++) {
+            if (enemies[i].health > 0) {
+                total_exp += enemies[i].exp_reward;
+                total_gold += enemies[i].gold_reward;
+            }
+        }
+
         // Start combat
-        while (enemy->health > 0 && adv->stats.health > 0) {
-            combat_round(adv, enemy);
+        while (battle.living > 0 && adv->stats.health > 0) {
+            display_combat_menu(adv, enemies, num_enemies);
+
+            // Pure game logic, the render thread reports what happened
+            combat_round(adv, &battle, &queue, 1);
             
-            // Check if enemy is defeated
-            if (enemy->health <= 0) {
-                clear();
-                print_center(1, "~~~ Victory! ~~~");
-                print_center(3, "You defeated the %s!", enemy->name);
-                print_center(5, "Gained %d XP", enemy->exp_reward);
-                print_center(6, "Gained %d Gold", enemy->gold_reward);
-                gain_experience(adv, enemy->exp_reward);
-                adv->gold += enemy->gold_reward;
-                refresh();
-                getch();
+            // Check if all enemies are defeated
+            if (battle.living == 0) {
+                save_request(); // Autosave after every victory
+
+                render_scene("~~~ Victory! ~~~");
+                // Only count this fight, some may have fallen on an earlier visit
+                if (battle.defeated > 1) {
+                    render_scene_line("You defeated all %d enemies!", battle.defeated);
+                } else {
+                    render_scene_line("You defeated the %s!", first_foe->name);
+                }
+                render_scene_line("");
+                render_scene_line("Gained %d XP", total_exp);
+                render_scene_line("Gained %d Gold", total_gold);
                 break;
             }
             
             // Check if player is defeated
             if (adv->stats.health <= 0) {
-                clear();
-                print_center(1, "~~~ Game Over ~~~");
-                print_center(3, "You have been defeated by the %s!", enemy->name);
-                print_center(5, "Better luck next time...");
-                refresh();
-                getch();
+                render_scene("~~~ Game Over ~~~");
+                render_scene_line("You have been defeated!");
+                render_scene_line("");
+                render_scene_line("Better luck next time...");
                 game_running = 0;
                 break;
             }
@@ -588,135 +715,313 @@ void encounter_enemy(Adventurer *adv, const Location *location) {
         }
     } else if (ch == '2') {
         // Simple run away chance
-        int escape_chance = 70; // 70% chance to escape
-        if (rand() % 100 < escape_chance) {
-            clear();
-            print_center(1, "~~~ Escape Successful! ~~~");
-            print_center(3, "You escaped from the %s.", enemy->name);
-            refresh();
-            getch();
+        if (rand() % 100 < balance_current()->escape_chance) {
+            render_scene("~~~ Escape Successful! ~~~");
+            render_scene_line("You escaped from the %s.", enemies[battle.first_alive].name);
         } else {
-            clear();
-            print_center(1, "~~~ Escape Failed! ~~~");
-            print_center(3, "You couldn't escape from the %s.", enemy->name);
-            refresh();
-            getch();
-            // Enemy attacks on failed escape
-            combat_round(adv, enemy);
+            render_scene("~~~ Escape Failed! ~~~");
+            render_scene_line("You couldn't escape from the %s.", enemies[battle.first_alive].name);
+            // Enemies get their turns while the player is busy fleeing
+            combat_round(adv, &battle, &queue, 0);
         }
     }
+
+    initiative_free(&queue);
 }
 
-void display_combat_menu(const Adventurer *adv, const Enemy *enemy) {
-    clear();
-    print_center(1, "~~~ Combat ~~~");
-    print_center(3, "%s (HP: %d/%d)", enemy->name, enemy->health, enemy->max_health);
-    print_center(5, "%s (HP: %d/%d)", adv->name, adv->stats.health, adv->stats.max_health);
-    print_center(7, "1. Attack");
-    print_center(8, "2. Use Item");
-    print_center(9, "3. Run Away");
-    refresh();
+// Hands the render thread this round's combat screen
+void display_combat_menu(const Adventurer *adv, const Enemy *enemies, int num_enemies) {
+    render_scene("~~~ Combat ~~~");
+    for (int i = 0; i < num_enemies; i++) {
+        if (enemies[i].health > 0) {
+            render_scene_line("%s (HP: %d/%d)", enemies[i].name, enemies[i].health, enemies[i].max_health);
+        } else {
+            render_scene_line("%s (defeated)", enemies[i].name);
+        }
+    }
+    render_scene_line("");
+    render_scene_line("%s (HP: %d/%d)", adv->name, adv->stats.health, adv->stats.max_health);
+    render_scene_line("");
+    render_scene_line("1. Attack    2. Use Item    3. Run Away");
 }
 
-void combat_round(Adventurer *adv, Enemy *enemy) {
-    display_combat_menu(adv, enemy);
-    
-    // Player attacks first
-    int player_damage = calculate_damage(adv->stats.strength, enemy->defense);
-    enemy->health -= player_damage;
-    if (enemy->health < 0) enemy->health = 0;
-    
-    clear();
-    print_center(1, "~~~ Combat Round ~~~");
-    print_center(3, "%s attacks %s for %d damage!", adv->name, enemy->name, player_damage);
-    
-    // Enemy attacks back
-    int enemy_damage = calculate_damage(enemy->attack, adv->stats.defense);
-    adv->stats.health -= enemy_damage;
-    if (adv->stats.health < 0) adv->stats.health = 0;
-    
-    print_center(5, "%s attacks %s for %d damage!", enemy->name, adv->name, enemy_damage);
-    refresh();
-    getch();
+int living_enemies(const Enemy *enemies, int num_enemies) {
+    int count = 0;
+    for (int i = 0; i < num_enemies; i++) {
+        if (enemies[i].health > 0) count++;
+    }
+    return count;
+}
+
+void defeat_enemy(Adventurer *adv, Enemy *enemy) {
+    render_event(EVENT_VICTORY, adv->name, enemy->name, enemy->exp_reward, enemy->gold_reward);
+    gain_experience(adv, enemy->exp_reward);
+    adv->gold += enemy->gold_reward;
+
+    quest_progress(adv, QUEST_DEFEAT, enemy->name);
+
+    const LootTable *loot = loot_for_enemy(enemy_loot, NUM_ENEMY_LOOT, enemy->name);
+    const Item *drop = loot != NULL ? loot_roll(loot, &loot_rng) : NULL;
+    if (drop != NULL) {
+        Item item = *drop;
+        describe_item(&item, (unsigned long)rand());
+        // A full pack leaves the drop on the floor, nothing to announce
+        if (add_item_to_inventory(adv, &item)) {
+            render_event(EVENT_ITEM_PICKUP, adv->name, item.name, 0, 0);
+            quest_progress(adv, QUEST_COLLECT, item.name);
+        }
+    }
 }
 
-int calculate_damage(int attack, int defense) {
-    int damage = attack - defense/2;
-    if (damage < 1) damage = 1;
-    return damage;
+// Takes a fallen enemy out of the turn order and the fight's counts
+void remove_enemy(Battle *battle, InitiativeQueue *queue, int index) {
+    initiative_remove(queue, index + 1);
+    battle->living--;
+    battle->defeated++;
+
+    // Enemies only fall, so the first one standing only ever moves on
+    while (battle->first_alive < battle->num_enemies && battle->enemies[battle->first_alive].health <= 0) {
+        battle->first_alive++;
+    }
+}
+
+// Plays turns in initiative order up to and including the player's next
+// turn. Faster combatants can act several times before the player does.
+void combat_round(Adventurer *adv, Battle *battle, InitiativeQueue *queue, int player_attacks) {
+    while (adv->stats.health > 0 && battle->living > 0) {
+        int combatant = initiative_next(queue);
+        if (combatant < 0) break;
+
+        if (combatant == 0) {
+            if (player_attacks) {
+                // Player attacks the first enemy still standing
+                Enemy *target = &battle->enemies[battle->first_alive];
+
+                int player_damage = calculate_damage(adv->stats.strength, target->defense);
+                target->health -= player_damage;
+                if (target->health < 0) target->health = 0;
+                render_event(EVENT_DAMAGE, adv->name, target->name, player_damage, 0);
+
+                if (target->health == 0) {
+                    remove_enemy(battle, queue, battle->first_alive);
+                    defeat_enemy(adv, target);
+                }
+            }
+            break;
+        }
+
+        // Enemy attacks
+        Enemy *enemy = &battle->enemies[combatant - 1];
+        int enemy_damage = calculate_damage(enemy->attack, adv->stats.defense);
+        adv->stats.health -= enemy_damage;
+        if (adv->stats.health < 0) adv->stats.health = 0;
+        render_event(EVENT_DAMAGE, enemy->name, adv->name, enemy_damage, 0);
+
+        if (adv->stats.health == 0) {
+            render_event(EVENT_DEFEAT, adv->name, enemy->name, 0, 0);
+        }
+    }
 }
 
 void gain_experience(Adventurer *adv, int exp_gained) {
     adv->stats.experience += exp_gained;
     
     // Check for level up
-    if (adv->stats.experience >= adv->stats.level * 100) {
+    if (adv->stats.experience >= experience_for_level(adv->stats.level)) {
         level_up(adv);
     }
 }
 
 void level_up(Adventurer *adv) {
-    adv->stats.level++;
+    rules_level_up(&adv->stats, &adv->gold, (uint64_t)rand());
     
-    // Improve stats based on class
-    switch (adv->stats.level % 3) {
-        case 0: // Warrior
-            adv->stats.max_health += 10;
-            adv->stats.health = adv->stats.max_health;
-            adv->stats.strength += 2;
-            break;
-        case 1: // Mage
-            adv->stats.max_mana += 10;
-            adv->stats.mana = adv->stats.max_mana;
-            adv->stats.intelligence += 2;
-            break;
-        case 2: // Rogue
-            adv->stats.max_health += 5;
-            adv->stats.max_mana += 5;
-            adv->stats.health = adv->stats.max_health;
-            adv->stats.mana = adv->stats.max_mana;
-            adv->stats.agility += 2;
-            break;
+    render_event(EVENT_LEVEL_UP, adv->name, NULL, adv->stats.level, 0);
+    save_request();
+}
+
+void display_location_menu(const Location *location) {
+    static Screen menu;
+
+    if (!screen_begin(&menu, location, sizeof(*location))) {
+        screen_center(&menu, 1, "~~~ %s ~~~", location->name);
+        screen_center(&menu, 3, "%s", location->description);
+
+        if (location->num_items > 0) {
+            screen_center(&menu, 5, "Items here:");
+            for (int i = 0; i < location->num_items; i++) {
+                screen_text(&menu, 6 + i, 5, "%d. Pick up %s", i+1, location->items[i].name);
+            }
+        }
+
+        if (location->has_enemy) {
+            screen_center(&menu, 10, "You hear a menacing presence...");
+        }
+
+        screen_center(&menu, LINES - 3, "1. Move to another location");
+        screen_center(&menu, LINES - 2, "2. Look around");
+        screen_center(&menu, LINES - 1, "Press any key to continue...");
     }
-    
+
+    if (!ui_trylock()) return; // The render thread is drawing, skip it
     clear();
-    print_center(1, "~~~ Level Up! ~~~");
-    print_center(3, "Congratulations! You reached level %d!", adv->stats.level);
+    screen_draw(&menu);
     refresh();
-    getch();
+    getch(); // Wait for a key press
+    ui_unlock();
 }
 
-void display_location_menu(const Location *location) {
+void display_message_log(void) {
+    if (!ui_trylock()) return; // The render thread is drawing, skip it
     clear();
-    print_center(1, "~~~ %s ~~~", location->name);
-    print_center(3, "%s", location->description);
-    
-    if (location->num_items > 0) {
-        print_center(5, "Items here:");
-        for (int i = 0; i < location->num_items; i++) {
-            mvprintw(6 + i, 5, "%d. Pick up %s", i+1, location->items[i].name);
-        }
+    print_center(1, "~~~ Message Log ~~~");
+
+    int rows = LINES - 5;
+    int count = render_log_count();
+    if (count > rows) count = rows;
+    if (count == 0) {
+        print_center(3, "Nothing has happened yet.");
     }
-    
-    if (location->has_enemy) {
-        print_center(10, "You hear a menacing presence...");
+    for (int i = 0; i < count; i++) {
+        // Oldest of the visible messages at the top
+        mvaddnstr(3 + i, 5, render_log_line(count - 1 - i), COLS - 5);
     }
-    
-    print_center(LINES - 3, "1. Move to another location");
-    print_center(LINES - 2, "2. Look around");
-    print_center(LINES - 1, "Press any key to continue...");
+
+    print_center(LINES - 2, "Press any key to continue...");
     refresh();
     getch(); // Wait for a key press
+    ui_unlock();
 }
 
-void main_game_loop(Adventurer *adv, const Location *locations) {
+void generate_quests(void) {
+    int quest;
+
+    quest_init(&quest_log);
+
+    quest = quest_add(&quest_log, "The Healer's Moss", "The healer in town needs moss from the forest.", 15, 20);
+    quest_add_objective(&quest_log, quest, QUEST_COLLECT, "Forest Moss", 1);
+
+    // Every world has at least one goblin but not always two, asking for
+    // more could leave the quest impossible
+    quest = quest_add(&quest_log, "Goblin Trouble", "A goblin keeps raiding the forest road.", 20, 30);
+    quest_add_objective(&quest_log, quest, QUEST_DEFEAT, "Goblin", 1);
+
+    quest = quest_add(&quest_log, "Into the Dark", "Find what the orc of the cave is hoarding.", 50, 80);
+    quest_add_objective(&quest_log, quest, QUEST_VISIT, "Cave", 1);
+    quest_add_objective(&quest_log, quest, QUEST_DEFEAT, "Orc", 1);
+    quest_add_objective(&quest_log, quest, QUEST_COLLECT, "Gold Coin", 1);
+}
+
+// Feeds one game event to the quests and pays out any it finished
+void quest_progress(Adventurer *adv, QuestTrigger trigger, const char *target) {
+    int completed[MAX_QUESTS];
+    int num_completed = quest_event(&quest_log, trigger, target, completed);
+
+    for (int i = 0; i < num_completed; i++) {
+        const Quest *quest = &quest_log.quests[completed[i]];
+        render_event(EVENT_QUEST_DONE, adv->name, quest->name, quest->reward_experience, quest->reward_gold);
+        adv->gold += quest->reward_gold;
+        gain_experience(adv, quest->reward_experience);
+    }
+}
+
+void display_quest_log(void) {
+    if (!ui_trylock()) return; // The render thread is drawing, skip it
+    clear();
+    print_center(1, "~~~ Quests ~~~");
+
+    int y = 3;
+    for (int i = 0; i < quest_log.num_quests && y < LINES - 3; i++) {
+        const Quest *quest = &quest_log.quests[i];
+        mvprintw(y++, 5, "%s%s", quest->name, quest->remaining == 0 ? " (done)" : "");
+        mvaddnstr(y++, 7, quest->description, COLS - 7);
+        for (int j = 0; j < quest->num_objectives && y < LINES - 3; j++) {
+            const QuestObjective *objective = &quest_log.objectives[quest->first_objective + j];
+            mvprintw(y++, 9, "%s %s: %d/%d",
+                     objective->trigger == QUEST_COLLECT ? "Collect" :
+                     objective->trigger == QUEST_DEFEAT ? "Defeat" : "Visit",
+                     objective->target, objective->progress, objective->required);
+        }
+        y++;
+    }
+
+    print_center(LINES - 2, "Press any key to continue...");
+    refresh();
+    getch(); // Wait for a key press
+    ui_unlock();
+}
+
+// Lets the bot decide and returns the key a player would have pressed
+// Maps the world for the bot. If it can't, a human takes over.
+int bot_prepare(const Location *locations) {
+    if (bot_world_init(&bot_world, item_catalog, NUM_CATALOG_ITEMS, locations, enemy_loot, NUM_ENEMY_LOOT)) {
+        return 1;
+    }
+    player_type = PLAYER_HUMAN;
+    return 0;
+}
+
+int bot_key(const Adventurer *adv, int in_encounter) {
+    BotState state;
+    int action;
+
+    bot_observe(&state, &bot_world, adv, bot_locations, bot_rng++);
+    state.in_encounter = (uint8_t)in_encounter;
+    state.turns = (int16_t)bot_turns++;
+
+    double start = (double)clock() / CLOCKS_PER_SEC;
+    if (player_type == PLAYER_MCTS_BOT) {
+        action = bot_mcts(&state, &bot_world, BOT_MCTS_ITERATIONS, &bot_rng);
+    } else {
+        action = bot_greedy(&state, &bot_world);
+    }
+    bot_think_seconds += (double)clock() / CLOCKS_PER_SEC - start;
+
+    if (action < 0 || bot_game_over(&state)) return 'q'; // Nothing left to do
+    if (action < BOT_MOVE + NUM_LOCATIONS) return '1' + action - BOT_MOVE;
+    switch (action) {
+        case BOT_PICK_UP: return 'g';
+        case BOT_USE_ITEM: return 'u';
+        case BOT_FIGHT: return '1';
+        default: return '2'; // Run
+    }
+}
+
+void main_game_loop(Adventurer *adv, Location *locations) {
     int ch;
 
     while (game_running) {
-        display_status_line(adv, locations);
-        refresh();
+        // If the render thread is busy drawing, skip this redraw and check
+        // for input next time round rather than waiting on the terminal
+        ch = ERR;
+        if (ui_trylock()) {
+            display_status_line(adv, locations);
+            refresh();
+
+            ch = getch(); // Get player input
+            ui_unlock();
+        }
 
-        ch = getch(); // Get player input
+        // 'q' still stops a bot
+        if (player_type != PLAYER_HUMAN && ch != 'q') {
+            napms(BOT_DELAY_MS);
+            ch = bot_key(adv, 0);
+        }
+
+        save_tick(); // Periodic autosave, only hands a snapshot to the saver
+
+        // Nothing from the balance tables or scripts is held across this
+        // point, so the hot reloader may free old ones after it
+        int reloaded = balance_quiescent();
+        if (reloaded > 0) {
+            refresh_enemies(locations);
+            if (player_type != PLAYER_HUMAN && !bot_prepare(locations)) {
+                render_scene("~~~ The bot gave up ~~~");
+                render_scene_line("It can't play with the new tables, the controls are yours.");
+            }
+        }
+        if (reloaded != 0) {
+            render_event(EVENT_RELOADED, adv->name, NULL, reloaded > 0, 0);
+        }
 
         switch (ch) {
             case 'q':
@@ -734,11 +1039,20 @@ void main_game_loop(Adventurer *adv, const Location *locations) {
                 // Look around at current location
                 display_location_info(&locations[adv->current_location]);
                 break;
+            case 'm':
+                // Show the message log
+                display_message_log();
+                break;
+            case 'j':
+                // Show the quest journal
+                display_quest_log();
+                break;
             case '1':
             case '2':
             case '3':
                 if (ch - '1' < NUM_LOCATIONS) {
                     move_to_location(adv, ch - '1', locations);
+                    quest_progress(adv, QUEST_VISIT, locations[adv->current_location].name);
                     
                     // Check for enemy encounter
                     if (locations[adv->current_location].has_enemy) {
@@ -749,19 +1063,20 @@ void main_game_loop(Adventurer *adv, const Location *locations) {
             case 'g':
                 // Pick up items from current location (if any)
                 {
-                    Location *current_location = (Location *)&locations[adv->current_location];
+                    Location *current_location = &locations[adv->current_location];
                     if (current_location->num_items > 0) {
-                        // Simple item pickup - add first item to inventory
+                        // Simple item pickup - add first item to inventory,
+                        // with a full pack it stays where it is
                         Item *item = &current_location->items[0];
-                        add_item_to_inventory(adv, item);
+                        if (!add_item_to_inventory(adv, item)) break;
+                        render_event(EVENT_ITEM_PICKUP, adv->name, item->name, 0, 0);
+                        quest_progress(adv, QUEST_COLLECT, item->name);
                         
-                        clear();
-                        print_center(1, "You picked up %s!", item->name);
-                        refresh();
-                        getch();
-                        
-                        // Remove item from location (simplified)
+                        // Remove item from location
                         current_location->num_items--;
+                        for (int i = 0; i < current_location->num_items; i++) {
+                            current_location->items[i] = current_location->items[i + 1];
+                        }
                     }
                 }
                 break;
@@ -776,28 +1091,98 @@ void main_game_loop(Adventurer *adv, const Location *locations) {
     }
 }
 
-int main() {
+int main(int argc, char *argv[]) {
     // Seed random number generator
     srand((unsigned int)time(NULL));
+
+    // --bot greedy or --bot mcts lets the computer play, e.g. to make load
+    if (argc == 3 && strcmp(argv[1], "--bot") == 0) {
+        if (strcmp(argv[2], "greedy") == 0) {
+            player_type = PLAYER_GREEDY_BOT;
+        } else if (strcmp(argv[2], "mcts") == 0) {
+            player_type = PLAYER_MCTS_BOT;
+        }
+    }
+    if (argc > 1 && player_type == PLAYER_HUMAN) {
+        fprintf(stderr, "usage: %s [--bot greedy|mcts]\n", argv[0]);
+        return 1;
+    }
     
     Adventurer adventurer;
     Location locations[NUM_LOCATIONS] = {
-        {"Town", "A bustling town with shops and villagers.", 0, {0}, 0, {{0}}},
-        {"Forest", "A dense forest filled with mysterious creatures.", 0, {0}, 0, {{0}}},
-        {"Cave", "A dark cave with hidden treasures.", 0, {0}, 0, {{0}}},
+        {"Town", "", 0, 0, {{0}}, 0, {{0}}},
+        {"Forest", "", 0, 0, {{0}}, 0, {{0}}},
+        {"Cave", "", 0, 0, {{0}}, 0, {{0}}},
     };
 
+    // Item effects, level up rules and scripted events
+    char content_error[160];
+    if (vm_load_scripts(SCRIPTS_PATH, content_error, sizeof(content_error)) < 0) {
+        fprintf(stderr, "%s\n", content_error);
+    }
+
+    // Balance tables, both files are reloaded when they change on disk
+    if (!balance_start(BALANCE_PATH, SCRIPTS_PATH, content_error, sizeof(content_error))) {
+        fprintf(stderr, "%s, using built in balance\n", content_error);
+    }
+
     // Generate world
+    lore_init();
+    generate_quests();
+    unsigned long world_seed = (unsigned long)rand();
+    loot_rng = ((uint64_t)rand() << 32) ^ (uint64_t)rand();
+    generate_loot_tables(locations);
     for (int i = 0; i < NUM_LOCATIONS; i++) {
-        generate_location_items(&locations[i]);
-        generate_enemy(&locations[i]);
+        lore_generate(LORE_LOCATION, locations[i].name, world_seed + i,
+                      locations[i].description, sizeof(locations[i].description));
+        generate_location_items(&locations[i], &location_loot[i],
+                                world_seed + NUM_LOCATIONS + i * MAX_LOCATION_ITEMS);
+        generate_enemies(&locations[i]);
+    }
+    if (player_type != PLAYER_HUMAN && !bot_prepare(locations)) {
+        fprintf(stderr, "The bot can't play with these loot tables, playing as a human\n");
+    }
+    if (player_type != PLAYER_HUMAN) {
+        bot_locations = locations;
+        bot_rng = loot_rng ^ 0x5DEECE66DULL;
     }
 
     init_ncurses();
     create_character(&adventurer);
+
+    // Drawing of game events happens on its own thread from here on
+    render_start();
+    save_start(AUTOSAVE_PATH, &adventurer, &quest_log, locations, NUM_LOCATIONS);
     main_game_loop(&adventurer, locations);
+    save_request(); // Save on the way out, save_stop() waits for it
+    save_stop();
+    render_stop();
+    balance_stop();
 
     endwin(); // End NCurses
 
+    SaveStats stats = save_stats();
+    printf("Autosave: %lu requested, %lu written, %lu failed, worst input stall %.1f us\n",
+           stats.saves_requested, stats.saves_written, stats.saves_failed,
+           stats.worst_stall_ns / 1000.0);
+    BalanceStats reload_stats = balance_stats();
+    if (reload_stats.reloads > 0 || reload_stats.failures > 0) {
+        printf("Hot reload: %lu reloads, %lu failed%s%s\n", reload_stats.reloads, reload_stats.failures,
+               reload_stats.failures > 0 ? ", last error: " : "", reload_stats.last_error);
+    }
+    if (player_type != PLAYER_HUMAN) {
+        printf("Bot: %d moves, %.1f us thinking per move, level %d, %d XP, %d gold%s\n",
+               bot_turns, bot_turns ? bot_think_seconds / bot_turns * 1e6 : 0.0,
+               adventurer.stats.level, adventurer.stats.experience, adventurer.gold,
+               adventurer.stats.health > 0 ? "" : ", died");
+    }
+
+    for (int i = 0; i < NUM_LOCATIONS; i++) {
+        loot_free(&location_loot[i]);
+    }
+    for (int i = 0; i < NUM_ENEMY_LOOT; i++) {
+        loot_free(&enemy_loot[i].table);
+    }
+
     return 0;
 }
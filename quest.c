@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include <string.h>
+#include "hash.h"
+#include "quest.h"
+
+// Over the trigger and the target name
+static unsigned long quest_hash(QuestTrigger trigger, const char *target) {
+    unsigned char kind = (unsigned char)trigger;
+    return hash_bytes(hash_bytes(HASH_START, &kind, 1), target, strlen(target));
+}
+
+void quest_init(QuestLog *log) {
+    memset(log, 0, sizeof(*log));
+    for (int i = 0; i < QUEST_INDEX_SIZE; i++) {
+        log->index[i] = -1;
+    }
+}
+
+int quest_add(QuestLog *log, const char *name, const char *description, int reward_gold, int reward_experience) {
+    if (log->num_quests == MAX_QUESTS) return -1;
+
+    Quest *quest = &log->quests[log->num_quests];
+    snprintf(quest->name, sizeof(quest->name), "%s", name);
+    snprintf(quest->description, sizeof(quest->description), "%s", description);
+    quest->reward_gold = reward_gold;
+    quest->reward_experience = reward_experience;
+    quest->first_objective = log->num_objectives;
+    quest->num_objectives = 0;
+    quest->remaining = 0;
+    return log->num_quests++;
+}
+
+int quest_add_objective(QuestLog *log, int quest, QuestTrigger trigger, const char *target, int required) {
+    if (log->num_objectives == MAX_QUEST_OBJECTIVES) return 0;
+    if (quest != log->num_quests - 1 || required < 1) return 0;
+
+    int id = log->num_objectives++;
+    QuestObjective *objective = &log->objectives[id];
+    objective->trigger = trigger;
+    snprintf(objective->target, sizeof(objective->target), "%s", target);
+    objective->hash = quest_hash(trigger, objective->target);
+    objective->required = required;
+    objective->progress = 0;
+    objective->quest = quest;
+
+    // Push onto its bucket
+    int *head = &log->index[objective->hash & (QUEST_INDEX_SIZE - 1)];
+    objective->next = *head;
+    *head = id;
+
+    log->quests[quest].num_objectives++;
+    log->quests[quest].remaining++;
+    return 1;
+}
+
+int quest_event(QuestLog *log, QuestTrigger trigger, const char *target, int *completed) {
+    unsigned long hash = quest_hash(trigger, target);
+    int *link = &log->index[hash & (QUEST_INDEX_SIZE - 1)];
+    int num_completed = 0;
+
+    while (*link != -1) {
+        QuestObjective *objective = &log->objectives[*link];
+        if (objective->hash != hash || objective->trigger != trigger || strcmp(objective->target, target) != 0) {
+            link = &objective->next;
+            continue;
+        }
+
+        if (++objective->progress < objective->required) {
+            link = &objective->next;
+            continue;
+        }
+
+        // Finished, unlink it so it never costs anything again
+        *link = objective->next;
+        objective->next = -1;
+        if (--log->quests[objective->quest].remaining == 0) {
+            completed[num_completed++] = objective->quest;
+        }
+    }
+    return num_completed;
+}
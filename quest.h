@@ -0,0 +1,59 @@
+#ifndef QUEST_H
+#define QUEST_H
+
+#define MAX_QUESTS 16
+#define MAX_QUEST_OBJECTIVES 64 // Shared by all quests
+#define QUEST_NAME_LEN 50
+#define QUEST_INDEX_SIZE 64 // Buckets for objective lookup, a power of two
+
+// The game events an objective can wait on
+typedef enum {
+    QUEST_COLLECT, // Pick up target
+    QUEST_DEFEAT,  // Defeat an enemy called target
+    QUEST_VISIT    // Arrive at the location called target
+} QuestTrigger;
+
+typedef struct {
+    QuestTrigger trigger;
+    char target[QUEST_NAME_LEN];
+    unsigned long hash; // Of trigger and target, saves most string compares
+    int required;
+    int progress;
+    int quest;
+    int next; // Next unfinished objective in the same bucket, -1 at the end
+} QuestObjective;
+
+typedef struct {
+    char name[QUEST_NAME_LEN];
+    char description[100];
+    int reward_gold;
+    int reward_experience;
+    int first_objective; // Objectives of a quest are stored next to each other
+    int num_objectives;
+    int remaining; // Objectives not finished yet, 0 once the quest is done
+} Quest;
+
+// Unfinished objectives are indexed by what they wait on, so an event only
+// looks at the objectives it can advance however many quests are active.
+// Plain arrays, the whole log can be copied with a struct assignment.
+typedef struct {
+    Quest quests[MAX_QUESTS];
+    QuestObjective objectives[MAX_QUEST_OBJECTIVES];
+    int index[QUEST_INDEX_SIZE]; // First objective per bucket, -1 if none
+    int num_quests;
+    int num_objectives;
+} QuestLog;
+
+void quest_init(QuestLog *log);
+
+// Returns the new quest's id, or -1 if the log is full
+int quest_add(QuestLog *log, const char *name, const char *description, int reward_gold, int reward_experience);
+
+// Objectives must be added right after their quest. Returns 0 if full.
+int quest_add_objective(QuestLog *log, int quest, QuestTrigger trigger, const char *target, int required);
+
+// Advances objectives waiting on this event. Ids of quests it finished go
+// in completed (room for MAX_QUESTS), returns how many there were.
+int quest_event(QuestLog *log, QuestTrigger trigger, const char *target, int *completed);
+
+#endif
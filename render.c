@@ -0,0 +1,250 @@
+#define _POSIX_C_SOURCE 200809L
+#include <ncurses.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "layout.h"
+#include "render.h"
+
+#define CACHE_LINE 64
+
+// Single producer (game thread), single consumer (render thread).
+// head and tail live on separate cache lines so the two threads do not
+// keep stealing the same line from each other.
+typedef struct {
+    unsigned head; // Next slot the producer writes, owned by the game thread
+    char pad1[CACHE_LINE - sizeof(unsigned)];
+    unsigned tail; // Next slot the consumer reads, owned by the render thread
+    char pad2[CACHE_LINE - sizeof(unsigned)];
+    unsigned dropped;
+    GameEvent events[EVENT_RING_SIZE];
+} EventRing;
+
+static EventRing ring;
+static sem_t ring_ready; // Wakes the render thread, sem_post never blocks
+static pthread_t render_thread;
+static pthread_mutex_t ui_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int render_running = 0;
+
+// Scrollback, written by the render thread under the UI lock
+static char message_log[MESSAGE_LOG_SIZE][MESSAGE_LEN];
+static int message_count = 0;
+
+// The scene being shown, only the render thread touches it
+static char scene_title[MESSAGE_LEN];
+static char scene_lines[SCENE_MAX_LINES][MESSAGE_LEN];
+static int scene_count = 0;
+
+static int ring_push(EventRing *r, const GameEvent *event) {
+    unsigned head = r->head;
+    unsigned tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+
+    if (head - tail == EVENT_RING_SIZE) return 0;
+
+    r->events[head & (EVENT_RING_SIZE - 1)] = *event;
+    __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+static int ring_pop(EventRing *r, GameEvent *event) {
+    unsigned tail = r->tail;
+    unsigned head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+
+    if (head == tail) return 0;
+
+    *event = r->events[tail & (EVENT_RING_SIZE - 1)];
+    __atomic_store_n(&r->tail, tail + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+void render_event(EventType type, const char *actor, const char *target, int value, int value2) {
+    GameEvent event;
+
+    event.type = type;
+    event.value = value;
+    event.value2 = value2;
+    strncpy(event.actor, actor != NULL ? actor : "", EVENT_NAME_LEN - 1);
+    event.actor[EVENT_NAME_LEN - 1] = '\0';
+    strncpy(event.target, target != NULL ? target : "", MESSAGE_LEN - 1);
+    event.target[MESSAGE_LEN - 1] = '\0';
+
+    if (!ring_push(&ring, &event)) {
+        __atomic_fetch_add(&ring.dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    if (render_running) sem_post(&ring_ready);
+}
+
+unsigned render_dropped_events(void) {
+    return __atomic_load_n(&ring.dropped, __ATOMIC_RELAXED);
+}
+
+void render_scene(const char *title) {
+    render_event(EVENT_SCENE, NULL, title, 0, 0);
+}
+
+void render_scene_line(const char *format, ...) {
+    char line[MESSAGE_LEN];
+    va_list args;
+
+    va_start(args, format);
+    vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    render_event(EVENT_SCENE_LINE, NULL, line, 0, 0);
+}
+
+void ui_lock(void) {
+    pthread_mutex_lock(&ui_mutex);
+}
+
+int ui_trylock(void) {
+    return pthread_mutex_trylock(&ui_mutex) == 0;
+}
+
+void ui_unlock(void) {
+    pthread_mutex_unlock(&ui_mutex);
+}
+
+int render_log_count(void) {
+    return message_count < MESSAGE_LOG_SIZE ? message_count : MESSAGE_LOG_SIZE;
+}
+
+const char *render_log_line(int index) {
+    return message_log[(message_count - 1 - index) % MESSAGE_LOG_SIZE];
+}
+
+static void format_event(const GameEvent *event, char *buffer, size_t size) {
+    switch (event->type) {
+        case EVENT_DAMAGE:
+            snprintf(buffer, size, "%s attacks %s for %d damage!", event->actor, event->target, event->value);
+            break;
+        case EVENT_ITEM_PICKUP:
+            snprintf(buffer, size, "%s picked up %s.", event->actor, event->target);
+            break;
+        case EVENT_ITEM_USED:
+            snprintf(buffer, size, "%s used %s and recovered %d HP.", event->actor, event->target, event->value);
+            break;
+        case EVENT_LEVEL_UP:
+            snprintf(buffer, size, "%s reached level %d!", event->actor, event->value);
+            break;
+        case EVENT_VICTORY:
+            snprintf(buffer, size, "%s defeated the %s. +%d XP, +%d gold.",
+                     event->actor, event->target, event->value, event->value2);
+            break;
+        case EVENT_DEFEAT:
+            snprintf(buffer, size, "%s was defeated by the %s.", event->actor, event->target);
+            break;
+        case EVENT_HEALED:
+            snprintf(buffer, size, "%s recovered %d HP in %s.", event->actor, event->value, event->target);
+            break;
+        case EVENT_QUEST_DONE:
+            snprintf(buffer, size, "Quest complete: %s! +%d XP, +%d gold.",
+                     event->target, event->value, event->value2);
+            break;
+        case EVENT_RELOADED:
+            snprintf(buffer, size, "%s", event->value ? "Game content was reloaded."
+                                                      : "Game content failed to reload, keeping the old.");
+            break;
+        case EVENT_SCENE:
+        case EVENT_SCENE_LINE:
+            break; // Drawn as a scene, not logged
+    }
+}
+
+// Scenes keep their own layouts, the shared layout cache belongs to the
+// game thread
+static void draw_scene(void) {
+    static Layout layout;
+    int bottom = LINES - 4 - MESSAGE_PANEL_ROWS;
+
+    clear();
+    layout_format(&layout, scene_title, (int)strlen(scene_title), COLS);
+    layout_draw(&layout, 1, LAYOUT_CENTER);
+    int y = 3;
+    for (int i = 0; i < scene_count && y < bottom; i++) {
+        layout_format(&layout, scene_lines[i], (int)strlen(scene_lines[i]), COLS);
+        y += layout_draw(&layout, y, LAYOUT_CENTER);
+    }
+}
+
+// Newest messages at the bottom of the screen, above the menu rows
+void render_draw_messages(void) {
+    int top = LINES - 4 - MESSAGE_PANEL_ROWS;
+    int shown = render_log_count() < MESSAGE_PANEL_ROWS ? render_log_count() : MESSAGE_PANEL_ROWS;
+
+    if (top < 1) return;
+    for (int row = 0; row < MESSAGE_PANEL_ROWS; row++) {
+        move(top + row, 0);
+        clrtoeol();
+        int index = shown - 1 - row;
+        if (index >= 0) mvaddnstr(top + row, 2, render_log_line(index), COLS - 2);
+    }
+    refresh();
+}
+
+static void *render_main(void *arg) {
+    GameEvent event;
+    char message[MESSAGE_LEN];
+    (void)arg;
+
+    while (__atomic_load_n(&render_running, __ATOMIC_ACQUIRE)) {
+        sem_wait(&ring_ready);
+
+        int drained = 0;
+        int scene_changed = 0;
+        while (ring_pop(&ring, &event)) {
+            if (event.type == EVENT_SCENE) {
+                memcpy(scene_title, event.target, MESSAGE_LEN);
+                scene_count = 0;
+                scene_changed = 1;
+                continue;
+            }
+            if (event.type == EVENT_SCENE_LINE) {
+                if (scene_count < SCENE_MAX_LINES) {
+                    memcpy(scene_lines[scene_count++], event.target, MESSAGE_LEN);
+                }
+                scene_changed = 1;
+                continue;
+            }
+
+            // Format outside the lock, only the terminal work is serialised
+            format_event(&event, message, sizeof(message));
+
+            ui_lock();
+            memcpy(message_log[message_count % MESSAGE_LOG_SIZE], message, MESSAGE_LEN);
+            message_count++;
+            ui_unlock();
+            drained++;
+        }
+
+        if (drained > 0 || scene_changed) {
+            ui_lock();
+            if (scene_changed) draw_scene();
+            render_draw_messages();
+            ui_unlock();
+        }
+    }
+    return NULL;
+}
+
+void render_start(void) {
+    if (render_running) return;
+
+    sem_init(&ring_ready, 0, 0);
+    __atomic_store_n(&render_running, 1, __ATOMIC_RELEASE);
+    if (pthread_create(&render_thread, NULL, render_main, NULL) != 0) {
+        render_running = 0;
+        sem_destroy(&ring_ready);
+    }
+}
+
+void render_stop(void) {
+    if (!render_running) return;
+
+    __atomic_store_n(&render_running, 0, __ATOMIC_RELEASE);
+    sem_post(&ring_ready);
+    pthread_join(render_thread, NULL);
+    sem_destroy(&ring_ready);
+}
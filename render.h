@@ -0,0 +1,64 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#define EVENT_RING_SIZE 256 // Must be a power of two
+#define EVENT_NAME_LEN 50
+#define MESSAGE_LOG_SIZE 128
+#define MESSAGE_LEN 100
+#define MESSAGE_PANEL_ROWS 4
+#define SCENE_MAX_LINES 12
+
+// Things game logic reports, the render thread turns them into messages
+typedef enum {
+    EVENT_DAMAGE,      // actor hit target for value damage
+    EVENT_ITEM_PICKUP, // actor picked up target
+    EVENT_ITEM_USED,   // actor used target, value is the effect amount
+    EVENT_LEVEL_UP,    // actor reached level value
+    EVENT_VICTORY,     // actor defeated target for value XP and value2 gold
+    EVENT_DEFEAT,      // actor was defeated by target
+    EVENT_HEALED,      // actor recovered value HP at target
+    EVENT_QUEST_DONE,  // actor finished quest target for value XP and value2 gold
+    EVENT_RELOADED,    // Game content changed on disk, value is 0 if it failed to load
+    EVENT_SCENE,       // Clears the screen for a new scene titled target
+    EVENT_SCENE_LINE   // Adds target as the next line of the scene
+} EventType;
+
+typedef struct {
+    EventType type;
+    int value;
+    int value2;
+    char actor[EVENT_NAME_LEN];
+    char target[MESSAGE_LEN]; // A name, or a whole line of a scene
+} GameEvent;
+
+// Starts and stops the render thread. ncurses must already be initialised.
+void render_start(void);
+void render_stop(void);
+
+// Publishes an event from the game thread. Never blocks: if the render
+// thread has fallen a whole ring behind the event is dropped and counted.
+void render_event(EventType type, const char *actor, const char *target, int value, int value2);
+unsigned render_dropped_events(void);
+
+// Announcements that take over the screen, like arriving somewhere or a
+// fight, are drawn by the render thread as well. The game thread only
+// formats the lines, it never waits on the terminal for them.
+void render_scene(const char *title);
+void render_scene_line(const char *format, ...);
+
+// ncurses is not thread safe, anything that draws must hold the UI lock
+void ui_lock(void);
+void ui_unlock(void);
+
+// Takes the UI lock only if it is free, returns 1 if it did. Game logic
+// uses this so a slow terminal on the render thread never holds it up.
+int ui_trylock(void);
+
+// Scrollback, only valid while holding the UI lock. Index 0 is the newest.
+int render_log_count(void);
+const char *render_log_line(int index);
+
+// Draws the newest messages above the bottom menu rows, needs the UI lock
+void render_draw_messages(void);
+
+#endif
@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include "balance.h"
+#include "rules.h"
+
+int calculate_damage(int attack, int defense) {
+    const Balance *balance = balance_current();
+    int damage = attack - defense / balance->damage_defense_divisor;
+    if (damage < balance->damage_minimum) damage = balance->damage_minimum;
+    return damage;
+}
+
+int experience_for_level(int level) {
+    return level * 100;
+}
+
+void rules_bind(VmContext *context, Stats *stats, int *gold, uint64_t seed) {
+    vm_context_init(context, seed);
+    vm_bind(context, VM_FIELD_HEALTH, &stats->health);
+    vm_bind(context, VM_FIELD_MAX_HEALTH, &stats->max_health);
+    vm_bind(context, VM_FIELD_MANA, &stats->mana);
+    vm_bind(context, VM_FIELD_MAX_MANA, &stats->max_mana);
+    vm_bind(context, VM_FIELD_STRENGTH, &stats->strength);
+    vm_bind(context, VM_FIELD_INTELLIGENCE, &stats->intelligence);
+    vm_bind(context, VM_FIELD_AGILITY, &stats->agility);
+    vm_bind(context, VM_FIELD_DEFENSE, &stats->defense);
+    vm_bind(context, VM_FIELD_LEVEL, &stats->level);
+    vm_bind(context, VM_FIELD_EXPERIENCE, &stats->experience);
+    vm_bind(context, VM_FIELD_GOLD, gold);
+}
+
+void rules_level_up(Stats *stats, int *gold, uint64_t seed) {
+    stats->level++;
+
+    // Growth rules come from the level_up script when there is one
+    const VmProgram *rules = vm_find_script("level_up");
+    if (rules != NULL) {
+        VmContext context;
+        rules_bind(&context, stats, gold, seed);
+        vm_run(rules, &context);
+        return;
+    }
+
+    // Improve stats based on class
+    switch (stats->level % 3) {
+        case 0: // Warrior
+            stats->max_health += 10;
+            stats->health = stats->max_health;
+            stats->strength += 2;
+            break;
+        case 1: // Mage
+            stats->max_mana += 10;
+            stats->mana = stats->max_mana;
+            stats->intelligence += 2;
+            break;
+        case 2: // Rogue
+            stats->max_health += 5;
+            stats->max_mana += 5;
+            stats->health = stats->max_health;
+            stats->mana = stats->max_mana;
+            stats->agility += 2;
+            break;
+    }
+}
+
+int rules_use_consumable(Stats *stats, int *gold, const Item *item, uint64_t seed) {
+    // The script is named after the item
+    const VmProgram *effect = vm_find_script(item->name);
+    if (effect != NULL) {
+        int value = item->value;
+        int rarity = item->rarity;
+        VmContext context;
+        rules_bind(&context, stats, gold, seed);
+        vm_bind(&context, VM_FIELD_ITEM_VALUE, &value);
+        vm_bind(&context, VM_FIELD_ITEM_RARITY, &rarity);
+        vm_run(effect, &context);
+        return context.result;
+    }
+
+    // No script, heal by the item's value
+    int amount = item->value;
+    if (stats->health + amount > stats->max_health) {
+        amount = stats->max_health - stats->health;
+    }
+    stats->health += amount;
+    return amount;
+}
+
+int rules_enter_location(Stats *stats, int *gold, const char *location, uint64_t seed) {
+    char script_name[VM_MAX_SCRIPT_NAME];
+    snprintf(script_name, sizeof(script_name), "enter %s", location);
+    const VmProgram *event = vm_find_script(script_name);
+    if (event == NULL) return 0;
+
+    VmContext context;
+    rules_bind(&context, stats, gold, seed);
+    vm_run(event, &context);
+    return context.result > 0 ? context.result : 0;
+}
@@ -0,0 +1,28 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include "game.h"
+#include "vm.h"
+
+// Game rules shared by the game and the auto-play bot, so the bot plays
+// by exactly the same numbers as a player.
+
+int calculate_damage(int attack, int defense);
+
+// Experience needed to go up from the given level
+int experience_for_level(int level);
+
+// Gives a script access to stats and gold and nothing else. seed drives
+// the script's rand, so the same seed always plays out the same way.
+void rules_bind(VmContext *context, Stats *stats, int *gold, uint64_t seed);
+
+// Goes up a level and grows stats, by the level_up script if there is one
+void rules_level_up(Stats *stats, int *gold, uint64_t seed);
+
+// Applies a consumable by its script, returns how much it healed
+int rules_use_consumable(Stats *stats, int *gold, const Item *item, uint64_t seed);
+
+// Runs the "enter <location>" script if any, returns the HP recovered
+int rules_enter_location(Stats *stats, int *gold, const char *location, uint64_t seed);
+
+#endif
@@ -0,0 +1,228 @@
+#define _GNU_SOURCE // SCHED_BATCH
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "save.h"
+
+#define SAVE_MAGIC "CDRPGSV1"
+#define SAVE_VERSION 2 // 2 added the quest log
+#define SAVE_PATH_LEN 256
+
+// Everything a save needs, copied by value so the saver never looks at
+// live game state
+typedef struct {
+    Adventurer adventurer;
+    QuestLog quest_log;
+    int num_locations;
+    Location locations[NUM_LOCATIONS];
+} SaveSnapshot;
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t adventurer_size;
+    uint32_t quest_log_size;
+    uint32_t location_size;
+    uint32_t num_locations;
+} SaveHeader;
+
+// Triple buffer: the game thread fills back, the saver writes front and
+// ready is handed between them. Only the index swap happens under the
+// mutex, copying and disk I/O never hold it.
+static SaveSnapshot slots[3];
+static int back_slot = 0;
+static int ready_slot = 1;
+static int front_slot = 2;
+static int ready_fresh = 0;
+static pthread_mutex_t slot_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t slot_cond = PTHREAD_COND_INITIALIZER;
+
+static pthread_t saver_thread;
+static int saver_running = 0;
+static char save_path[SAVE_PATH_LEN];
+static const Adventurer *save_adv;
+static const QuestLog *save_quest_log;
+static const Location *save_locations;
+static int save_num_locations;
+static struct timespec last_request;
+static SaveStats stats;
+
+static long elapsed_ns(const struct timespec *start, const struct timespec *end) {
+    return (long)(end->tv_sec - start->tv_sec) * 1000000000L + (end->tv_nsec - start->tv_nsec);
+}
+
+// fsync the directory so the rename itself survives a crash
+static void sync_directory(const char *path) {
+    char dir[SAVE_PATH_LEN];
+    const char *slash = strrchr(path, '/');
+
+    if (slash == NULL) {
+        strcpy(dir, ".");
+    } else {
+        size_t len = slash == path ? 1 : (size_t)(slash - path);
+        memcpy(dir, path, len);
+        dir[len] = '\0';
+    }
+
+    int fd = open(dir, O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+// Write to a temporary file, fsync it and rename it over the old save so
+// a crash mid-write never leaves a half written save behind
+static int write_snapshot(const SaveSnapshot *snapshot) {
+    char tmp_path[SAVE_PATH_LEN + 4];
+    SaveHeader header;
+
+    memcpy(header.magic, SAVE_MAGIC, sizeof(header.magic));
+    header.version = SAVE_VERSION;
+    header.adventurer_size = sizeof(Adventurer);
+    header.quest_log_size = sizeof(QuestLog);
+    header.location_size = sizeof(Location);
+    header.num_locations = (uint32_t)snapshot->num_locations;
+
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", save_path);
+    FILE *file = fopen(tmp_path, "wb");
+    if (file == NULL) return 0;
+
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(&snapshot->adventurer, sizeof(Adventurer), 1, file) == 1 &&
+             fwrite(&snapshot->quest_log, sizeof(QuestLog), 1, file) == 1 &&
+             fwrite(snapshot->locations, sizeof(Location), snapshot->num_locations, file) ==
+                 (size_t)snapshot->num_locations &&
+             fflush(file) == 0 &&
+             fsync(fileno(file)) == 0;
+
+    if (fclose(file) != 0) ok = 0;
+    if (ok && rename(tmp_path, save_path) != 0) ok = 0;
+    if (!ok) {
+        remove(tmp_path);
+        return 0;
+    }
+
+    sync_directory(save_path);
+    return 1;
+}
+
+static void *saver_main(void *arg) {
+    (void)arg;
+
+    // Batch threads do not preempt on wakeup, so handing over a snapshot
+    // never gives the game thread's time slice to the saver
+    struct sched_param param = {0};
+    pthread_setschedparam(pthread_self(), SCHED_BATCH, &param);
+
+    for (;;) {
+        pthread_mutex_lock(&slot_mutex);
+        while (saver_running && !ready_fresh) {
+            pthread_cond_wait(&slot_cond, &slot_mutex);
+        }
+        if (!ready_fresh) {
+            // Stopped with nothing left to write
+            pthread_mutex_unlock(&slot_mutex);
+            break;
+        }
+        int slot = ready_slot;
+        ready_slot = front_slot;
+        front_slot = slot;
+        ready_fresh = 0;
+        pthread_mutex_unlock(&slot_mutex);
+
+        int ok = write_snapshot(&slots[front_slot]);
+
+        pthread_mutex_lock(&slot_mutex);
+        if (ok) {
+            stats.saves_written++;
+        } else {
+            stats.saves_failed++;
+        }
+        pthread_mutex_unlock(&slot_mutex);
+    }
+    return NULL;
+}
+
+void save_start(const char *path, const Adventurer *adv, const QuestLog *quest_log,
+                const Location *locations, int num_locations) {
+    if (saver_running) return;
+
+    strncpy(save_path, path, SAVE_PATH_LEN - 1);
+    save_path[SAVE_PATH_LEN - 1] = '\0';
+    save_adv = adv;
+    save_quest_log = quest_log;
+    save_locations = locations;
+    save_num_locations = num_locations < NUM_LOCATIONS ? num_locations : NUM_LOCATIONS;
+    memset(slots, 0, sizeof(slots)); // Fault the pages in now, not in the first save
+    clock_gettime(CLOCK_MONOTONIC, &last_request);
+
+    saver_running = 1;
+    if (pthread_create(&saver_thread, NULL, saver_main, NULL) != 0) {
+        saver_running = 0;
+    }
+}
+
+void save_stop(void) {
+    if (!saver_running) return;
+
+    pthread_mutex_lock(&slot_mutex);
+    saver_running = 0;
+    pthread_cond_signal(&slot_cond);
+    pthread_mutex_unlock(&slot_mutex);
+    pthread_join(saver_thread, NULL);
+}
+
+void save_request(void) {
+    struct timespec start, end;
+
+    if (!saver_running) return;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    SaveSnapshot *snapshot = &slots[back_slot];
+    snapshot->adventurer = *save_adv;
+    snapshot->quest_log = *save_quest_log;
+    snapshot->num_locations = save_num_locations;
+    memcpy(snapshot->locations, save_locations, sizeof(Location) * save_num_locations);
+
+    // Publish the snapshot, an older one the saver has not picked up yet
+    // is simply replaced
+    pthread_mutex_lock(&slot_mutex);
+    int slot = ready_slot;
+    ready_slot = back_slot;
+    back_slot = slot;
+    ready_fresh = 1;
+    pthread_cond_signal(&slot_cond);
+    pthread_mutex_unlock(&slot_mutex);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    last_request = end;
+
+    long stall = elapsed_ns(&start, &end);
+    stats.saves_requested++;
+    stats.last_stall_ns = stall;
+    stats.total_stall_ns += stall;
+    if (stall > stats.worst_stall_ns) stats.worst_stall_ns = stall;
+}
+
+void save_tick(void) {
+    struct timespec now;
+
+    if (!saver_running) return;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (now.tv_sec - last_request.tv_sec >= AUTOSAVE_INTERVAL) {
+        save_request();
+    }
+}
+
+SaveStats save_stats(void) {
+    pthread_mutex_lock(&slot_mutex);
+    SaveStats copy = stats;
+    pthread_mutex_unlock(&slot_mutex);
+    return copy;
+}
@@ -0,0 +1,36 @@
+#ifndef SAVE_H
+#define SAVE_H
+
+#include "game.h"
+#include "quest.h"
+
+#define AUTOSAVE_PATH "autosave.dat"
+#define AUTOSAVE_INTERVAL 60 // Seconds between periodic saves
+
+// Instrumentation, the stall is how long the input loop spent in a save call
+typedef struct {
+    unsigned long saves_requested;
+    unsigned long saves_written;
+    unsigned long saves_failed;
+    long last_stall_ns;
+    long worst_stall_ns;
+    long total_stall_ns;
+} SaveStats;
+
+// Starts the background saver for the given game state. The pointers must
+// stay valid until save_stop(), they are only read from the game thread.
+void save_start(const char *path, const Adventurer *adv, const QuestLog *quest_log,
+                const Location *locations, int num_locations);
+
+// Writes the last requested snapshot (if any) and stops the saver thread
+void save_stop(void);
+
+// Snapshots the game state and hands it to the saver, never waits on disk
+void save_request(void);
+
+// Requests a save if AUTOSAVE_INTERVAL has passed, call once per input loop
+void save_tick(void);
+
+SaveStats save_stats(void);
+
+#endif
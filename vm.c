@@ -0,0 +1,517 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rng.h"
+#include "vm.h"
+
+// GCC and clang can jump straight to the next handler through a table of
+// label addresses, which saves the bounds check and shared indirect branch
+// of a switch. Anything else gets the switch.
+#if defined(__GNUC__) && !defined(VM_NO_COMPUTED_GOTO)
+#define VM_COMPUTED_GOTO 1
+#else
+#define VM_COMPUTED_GOTO 0
+#endif
+
+#define VM_OP(ins) ((ins) & 0xFF)
+#define VM_A(ins) (((ins) >> 8) & 0xFF)
+#define VM_B(ins) (((ins) >> 16) & 0xFF)
+#define VM_C(ins) (((ins) >> 24) & 0xFF)
+#define VM_IMM(ins) ((int16_t)((ins) >> 16))
+
+#define VM_MAX_LABELS 32
+#define VM_MAX_TOKEN 32
+#define VM_MAX_LINE 128
+
+typedef enum {
+    OPERAND_NONE,
+    OPERAND_REG,   // r0-r15, takes the next byte slot
+    OPERAND_FIELD, // a field name, takes the next byte slot
+    OPERAND_IMM8,  // signed byte, takes the next byte slot
+    OPERAND_IMM16, // signed 16 bits in b and c
+    OPERAND_LABEL  // instruction index in b and c
+} OperandKind;
+
+static const struct {
+    const char *name;
+    OperandKind operands[3];
+} vm_ops[VM_NUM_OPS] = {
+    [VM_OP_HALT] = {"halt", {OPERAND_NONE, OPERAND_NONE, OPERAND_NONE}},
+    [VM_OP_RET] = {"ret", {OPERAND_REG, OPERAND_NONE, OPERAND_NONE}},
+    [VM_OP_LOADI] = {"loadi", {OPERAND_REG, OPERAND_IMM16, OPERAND_NONE}},
+    [VM_OP_MOV] = {"mov", {OPERAND_REG, OPERAND_REG, OPERAND_NONE}},
+    [VM_OP_LOAD] = {"load", {OPERAND_REG, OPERAND_FIELD, OPERAND_NONE}},
+    [VM_OP_STORE] = {"store", {OPERAND_FIELD, OPERAND_REG, OPERAND_NONE}},
+    [VM_OP_ADD] = {"add", {OPERAND_REG, OPERAND_REG, OPERAND_REG}},
+    [VM_OP_SUB] = {"sub", {OPERAND_REG, OPERAND_REG, OPERAND_REG}},
+    [VM_OP_MUL] = {"mul", {OPERAND_REG, OPERAND_REG, OPERAND_REG}},
+    [VM_OP_DIV] = {"div", {OPERAND_REG, OPERAND_REG, OPERAND_REG}},
+    [VM_OP_MOD] = {"mod", {OPERAND_REG, OPERAND_REG, OPERAND_REG}},
+    [VM_OP_MIN] = {"min", {OPERAND_REG, OPERAND_REG, OPERAND_REG}},
+    [VM_OP_MAX] = {"max", {OPERAND_REG, OPERAND_REG, OPERAND_REG}},
+    [VM_OP_LT] = {"lt", {OPERAND_REG, OPERAND_REG, OPERAND_REG}},
+    [VM_OP_EQ] = {"eq", {OPERAND_REG, OPERAND_REG, OPERAND_REG}},
+    [VM_OP_ADDI] = {"addi", {OPERAND_REG, OPERAND_REG, OPERAND_IMM8}},
+    [VM_OP_JMP] = {"jmp", {OPERAND_LABEL, OPERAND_NONE, OPERAND_NONE}},
+    [VM_OP_JZ] = {"jz", {OPERAND_REG, OPERAND_LABEL, OPERAND_NONE}},
+    [VM_OP_JNZ] = {"jnz", {OPERAND_REG, OPERAND_LABEL, OPERAND_NONE}},
+    [VM_OP_RAND] = {"rand", {OPERAND_REG, OPERAND_REG, OPERAND_NONE}},
+};
+
+static const char *vm_field_names[VM_NUM_FIELDS] = {
+    "hp", "max_hp", "mana", "max_mana", "str", "int", "agi", "def",
+    "level", "exp", "gold", "value", "rarity",
+};
+
+// A whole set of scripts. A reload builds a new set and swaps it in, so a
+// script never changes while it runs.
+struct VmScripts {
+    struct {
+        char name[VM_MAX_SCRIPT_NAME];
+        VmProgram program;
+    } scripts[VM_MAX_SCRIPTS];
+    int count;
+};
+
+static VmScripts *vm_live_scripts; // NULL until something is loaded
+
+void vm_context_init(VmContext *context, uint64_t seed) {
+    context->scratch = 0;
+    for (int i = 0; i < VM_NUM_FIELDS; i++) {
+        context->fields[i] = &context->scratch;
+    }
+    context->rng = seed;
+    context->result = 0;
+}
+
+void vm_bind(VmContext *context, VmField field, int *value) {
+    if (field >= 0 && field < VM_NUM_FIELDS) {
+        context->fields[field] = value != NULL ? value : &context->scratch;
+    }
+}
+
+int vm_verify(const VmProgram *program) {
+    if (program->length <= 0 || program->length > VM_MAX_CODE) return 0;
+
+    for (int pc = 0; pc < program->length; pc++) {
+        uint32_t ins = program->code[pc];
+        int op = VM_OP(ins);
+        if (op >= VM_NUM_OPS) return 0;
+
+        int slot = 0;
+        for (int i = 0; i < 3; i++) {
+            switch (vm_ops[op].operands[i]) {
+                case OPERAND_REG:
+                    if (((ins >> (8 + 8 * slot++)) & 0xFF) >= VM_NUM_REGISTERS) return 0;
+                    break;
+                case OPERAND_FIELD:
+                    if (((ins >> (8 + 8 * slot++)) & 0xFF) >= VM_NUM_FIELDS) return 0;
+                    break;
+                case OPERAND_IMM8:
+                    slot++;
+                    break;
+                case OPERAND_LABEL:
+                    if (VM_IMM(ins) < 0 || VM_IMM(ins) >= program->length) return 0;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    // Execution must never run off the end of the program
+    int last = VM_OP(program->code[program->length - 1]);
+    return last == VM_OP_HALT || last == VM_OP_RET || last == VM_OP_JMP;
+}
+
+int vm_run(const VmProgram *program, VmContext *context) {
+    const uint32_t *code = program->code;
+    int *const *fields = context->fields;
+    int32_t r[VM_NUM_REGISTERS] = {0};
+    int jumps = VM_MAX_JUMPS;
+    int pc = 0;
+    uint32_t ins;
+
+    context->result = 0;
+
+#if VM_COMPUTED_GOTO
+    static void *const dispatch[VM_NUM_OPS] = {
+        [VM_OP_HALT] = &&do_HALT, [VM_OP_RET] = &&do_RET, [VM_OP_LOADI] = &&do_LOADI,
+        [VM_OP_MOV] = &&do_MOV, [VM_OP_LOAD] = &&do_LOAD, [VM_OP_STORE] = &&do_STORE,
+        [VM_OP_ADD] = &&do_ADD, [VM_OP_SUB] = &&do_SUB, [VM_OP_MUL] = &&do_MUL,
+        [VM_OP_DIV] = &&do_DIV, [VM_OP_MOD] = &&do_MOD, [VM_OP_MIN] = &&do_MIN,
+        [VM_OP_MAX] = &&do_MAX, [VM_OP_LT] = &&do_LT, [VM_OP_EQ] = &&do_EQ,
+        [VM_OP_ADDI] = &&do_ADDI, [VM_OP_JMP] = &&do_JMP, [VM_OP_JZ] = &&do_JZ,
+        [VM_OP_JNZ] = &&do_JNZ, [VM_OP_RAND] = &&do_RAND,
+    };
+#define VM_CASE(name) do_##name:
+#define VM_NEXT() do { ins = code[pc++]; goto *dispatch[VM_OP(ins)]; } while (0)
+    VM_NEXT();
+    {
+#else
+#define VM_CASE(name) case VM_OP_##name:
+#define VM_NEXT() goto next
+next:
+    ins = code[pc++];
+    switch (VM_OP(ins)) {
+#endif
+    VM_CASE(HALT)
+        return 1;
+    VM_CASE(RET)
+        context->result = r[VM_A(ins)];
+        return 1;
+    VM_CASE(LOADI)
+        r[VM_A(ins)] = VM_IMM(ins);
+        VM_NEXT();
+    VM_CASE(MOV)
+        r[VM_A(ins)] = r[VM_B(ins)];
+        VM_NEXT();
+    VM_CASE(LOAD)
+        r[VM_A(ins)] = *fields[VM_B(ins)];
+        VM_NEXT();
+    VM_CASE(STORE)
+        *fields[VM_A(ins)] = r[VM_B(ins)];
+        VM_NEXT();
+    // Scripts come from disk, so arithmetic wraps in uint32_t rather than
+    // overflowing, and no divisor can trap
+    VM_CASE(ADD)
+        r[VM_A(ins)] = (int32_t)((uint32_t)r[VM_B(ins)] + (uint32_t)r[VM_C(ins)]);
+        VM_NEXT();
+    VM_CASE(SUB)
+        r[VM_A(ins)] = (int32_t)((uint32_t)r[VM_B(ins)] - (uint32_t)r[VM_C(ins)]);
+        VM_NEXT();
+    VM_CASE(MUL)
+        r[VM_A(ins)] = (int32_t)((uint32_t)r[VM_B(ins)] * (uint32_t)r[VM_C(ins)]);
+        VM_NEXT();
+    VM_CASE(DIV)
+        // INT32_MIN / -1 traps, negating wraps it back to INT32_MIN instead
+        r[VM_A(ins)] = r[VM_C(ins)] == 0 ? 0 :
+                       r[VM_C(ins)] == -1 ? (int32_t)(0u - (uint32_t)r[VM_B(ins)]) :
+                       r[VM_B(ins)] / r[VM_C(ins)];
+        VM_NEXT();
+    VM_CASE(MOD)
+        r[VM_A(ins)] = r[VM_C(ins)] == 0 || r[VM_C(ins)] == -1 ? 0 : r[VM_B(ins)] % r[VM_C(ins)];
+        VM_NEXT();
+    VM_CASE(MIN)
+        r[VM_A(ins)] = r[VM_B(ins)] < r[VM_C(ins)] ? r[VM_B(ins)] : r[VM_C(ins)];
+        VM_NEXT();
+    VM_CASE(MAX)
+        r[VM_A(ins)] = r[VM_B(ins)] > r[VM_C(ins)] ? r[VM_B(ins)] : r[VM_C(ins)];
+        VM_NEXT();
+    VM_CASE(LT)
+        r[VM_A(ins)] = r[VM_B(ins)] < r[VM_C(ins)];
+        VM_NEXT();
+    VM_CASE(EQ)
+        r[VM_A(ins)] = r[VM_B(ins)] == r[VM_C(ins)];
+        VM_NEXT();
+    VM_CASE(ADDI)
+        r[VM_A(ins)] = (int32_t)((uint32_t)r[VM_B(ins)] + (uint32_t)(int8_t)VM_C(ins));
+        VM_NEXT();
+    VM_CASE(JMP)
+        if (--jumps == 0) return 0;
+        pc = VM_IMM(ins);
+        VM_NEXT();
+    VM_CASE(JZ)
+        if (r[VM_A(ins)] == 0) {
+            if (--jumps == 0) return 0;
+            pc = VM_IMM(ins);
+        }
+        VM_NEXT();
+    VM_CASE(JNZ)
+        if (r[VM_A(ins)] != 0) {
+            if (--jumps == 0) return 0;
+            pc = VM_IMM(ins);
+        }
+        VM_NEXT();
+    VM_CASE(RAND)
+        r[VM_A(ins)] = r[VM_B(ins)] > 0 ?
+            (int32_t)(((rng_next(&context->rng) & 0xFFFFFFFFULL) * (uint32_t)r[VM_B(ins)]) >> 32) : 0;
+        VM_NEXT();
+    }
+#undef VM_CASE
+#undef VM_NEXT
+
+    // Only reachable with an unknown opcode in the switch version
+    return 0;
+}
+
+// Copies the next whitespace or comma separated token, returns its length
+static int next_token(const char **p, char *token) {
+    int len = 0;
+
+    while (**p == ' ' || **p == '\t' || **p == ',') (*p)++;
+    while (**p != '\0' && **p != ' ' && **p != '\t' && **p != ',') {
+        if (len < VM_MAX_TOKEN - 1) token[len++] = **p;
+        (*p)++;
+    }
+    token[len] = '\0';
+    return len;
+}
+
+// Copies the next line of [*p, end) without comments or surrounding space
+static int next_line(const char **p, const char *end, char *line) {
+    int len = 0;
+
+    while (*p < end && **p != '\n') {
+        if (len < VM_MAX_LINE - 1) line[len++] = **p;
+        (*p)++;
+    }
+    if (*p < end) (*p)++;
+    line[len] = '\0';
+
+    char *comment = strpbrk(line, "#;");
+    if (comment != NULL) *comment = '\0';
+    len = (int)strlen(line);
+    while (len > 0 && isspace((unsigned char)line[len - 1])) line[--len] = '\0';
+
+    int start = 0;
+    while (isspace((unsigned char)line[start])) start++;
+    memmove(line, line + start, len - start + 1);
+    return len - start;
+}
+
+static int parse_int(const char *token, long *value) {
+    char *end;
+    *value = strtol(token, &end, 10);
+    return *token != '\0' && *end == '\0';
+}
+
+static int assemble_range(const char *start, const char *end, VmProgram *program, char *error, int error_size) {
+    char labels[VM_MAX_LABELS][VM_MAX_TOKEN];
+    int label_pc[VM_MAX_LABELS];
+    int num_labels = 0;
+    char line[VM_MAX_LINE];
+    char token[VM_MAX_TOKEN];
+    const char *p;
+    int pc;
+
+    // First pass: find where the labels point
+    pc = 0;
+    for (p = start; p < end;) {
+        int len = next_line(&p, end, line);
+        if (len == 0) continue;
+        if (line[len - 1] == ':') {
+            if (num_labels == VM_MAX_LABELS) {
+                snprintf(error, error_size, "too many labels");
+                return 0;
+            }
+            line[len - 1] = '\0';
+            snprintf(labels[num_labels], VM_MAX_TOKEN, "%.*s", VM_MAX_TOKEN - 1, line);
+            label_pc[num_labels++] = pc;
+        } else {
+            pc++;
+        }
+    }
+
+    // Second pass: encode, every script ends with an implicit halt
+    pc = 0;
+    for (p = start; p < end;) {
+        int len = next_line(&p, end, line);
+        if (len == 0 || line[len - 1] == ':') continue;
+
+        const char *q = line;
+        next_token(&q, token);
+
+        int op;
+        for (op = 0; op < VM_NUM_OPS; op++) {
+            if (strcmp(vm_ops[op].name, token) == 0) break;
+        }
+        if (op == VM_NUM_OPS) {
+            snprintf(error, error_size, "unknown instruction '%s'", token);
+            return 0;
+        }
+        if (pc >= VM_MAX_CODE - 1) {
+            snprintf(error, error_size, "script too long");
+            return 0;
+        }
+
+        uint32_t ins = (uint32_t)op;
+        int slot = 0;
+        for (int i = 0; i < 3 && vm_ops[op].operands[i] != OPERAND_NONE; i++) {
+            long value = 0;
+            if (next_token(&q, token) == 0) {
+                snprintf(error, error_size, "'%s' is missing an operand", vm_ops[op].name);
+                return 0;
+            }
+
+            switch (vm_ops[op].operands[i]) {
+                case OPERAND_REG:
+                    if (token[0] != 'r' || !parse_int(token + 1, &value) || value < 0 || value >= VM_NUM_REGISTERS) {
+                        snprintf(error, error_size, "bad register '%s'", token);
+                        return 0;
+                    }
+                    ins |= (uint32_t)value << (8 + 8 * slot++);
+                    break;
+                case OPERAND_FIELD:
+                    for (value = 0; value < VM_NUM_FIELDS; value++) {
+                        if (strcmp(vm_field_names[value], token) == 0) break;
+                    }
+                    if (value == VM_NUM_FIELDS) {
+                        snprintf(error, error_size, "unknown field '%s'", token);
+                        return 0;
+                    }
+                    ins |= (uint32_t)value << (8 + 8 * slot++);
+                    break;
+                case OPERAND_IMM8:
+                    if (!parse_int(token, &value) || value < -128 || value > 127) {
+                        snprintf(error, error_size, "bad small number '%s'", token);
+                        return 0;
+                    }
+                    ins |= (uint32_t)(uint8_t)value << (8 + 8 * slot++);
+                    break;
+                case OPERAND_IMM16:
+                    if (!parse_int(token, &value) || value < -32768 || value > 32767) {
+                        snprintf(error, error_size, "bad number '%s'", token);
+                        return 0;
+                    }
+                    ins |= (uint32_t)(uint16_t)value << 16;
+                    break;
+                case OPERAND_LABEL:
+                    for (value = 0; value < num_labels; value++) {
+                        if (strcmp(labels[value], token) == 0) break;
+                    }
+                    if (value == num_labels) {
+                        snprintf(error, error_size, "unknown label '%s'", token);
+                        return 0;
+                    }
+                    ins |= (uint32_t)(uint16_t)label_pc[value] << 16;
+                    break;
+                default:
+                    break;
+            }
+        }
+        program->code[pc++] = ins;
+    }
+
+    program->code[pc++] = VM_OP_HALT;
+    program->length = pc;
+
+    if (!vm_verify(program)) {
+        snprintf(error, error_size, "script failed verification");
+        return 0;
+    }
+    return 1;
+}
+
+int vm_assemble(const char *source, VmProgram *program, char *error, int error_size) {
+    return assemble_range(source, source + strlen(source), program, error, error_size);
+}
+
+static void vm_store_script(VmScripts *set, const char *name, const VmProgram *program) {
+    int i;
+    for (i = 0; i < set->count; i++) {
+        if (strcmp(set->scripts[i].name, name) == 0) break;
+    }
+    if (i == VM_MAX_SCRIPTS) return;
+    if (i == set->count) set->count++;
+
+    snprintf(set->scripts[i].name, VM_MAX_SCRIPT_NAME, "%s", name);
+    set->scripts[i].program = *program;
+}
+
+VmScripts *vm_parse_scripts(const char *path, char *error, int error_size) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        snprintf(error, error_size, "can't open %s", path);
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *source = malloc(size + 1);
+    VmScripts *set = calloc(1, sizeof(VmScripts));
+    if (source == NULL || set == NULL || fread(source, 1, size, file) != (size_t)size) {
+        free(source);
+        free(set);
+        fclose(file);
+        snprintf(error, error_size, "can't read %s", path);
+        return NULL;
+    }
+    source[size] = '\0';
+    fclose(file);
+
+    const char *end = source + size;
+    const char *p = source;
+    char line[VM_MAX_LINE];
+    int failed = 0;
+    int line_number = 0;
+
+    while (p < end) {
+        line_number++;
+        if (next_line(&p, end, line) == 0) continue;
+
+        if (strncmp(line, "script ", 7) != 0) {
+            snprintf(error, error_size, "%s:%d: expected 'script <name>'", path, line_number);
+            failed = 1;
+            break;
+        }
+
+        // The body runs until a line that says "end"
+        char name[VM_MAX_SCRIPT_NAME];
+        snprintf(name, sizeof(name), "%.*s", VM_MAX_SCRIPT_NAME - 1, line + 7);
+        int script_line = line_number;
+        const char *body = p;
+        const char *body_end = end;
+        int found_end = 0;
+        while (p < end) {
+            const char *line_start = p;
+            line_number++;
+            next_line(&p, end, line);
+            if (strcmp(line, "end") == 0) {
+                body_end = line_start;
+                found_end = 1;
+                break;
+            }
+        }
+        if (!found_end) {
+            snprintf(error, error_size, "%s:%d: script '%s' has no end", path, script_line, name);
+            failed = 1;
+            break;
+        }
+
+        VmProgram program;
+        char message[80];
+        if (!assemble_range(body, body_end, &program, message, sizeof(message))) {
+            snprintf(error, error_size, "%s:%d: %s: %s", path, script_line, name, message);
+            failed = 1;
+            break;
+        }
+        vm_store_script(set, name, &program);
+    }
+
+    free(source);
+    if (failed) {
+        free(set);
+        return NULL;
+    }
+    return set;
+}
+
+VmScripts *vm_swap_scripts(VmScripts *scripts) {
+    return __atomic_exchange_n(&vm_live_scripts, scripts, __ATOMIC_SEQ_CST);
+}
+
+void vm_free_scripts(VmScripts *scripts) {
+    free(scripts);
+}
+
+int vm_load_scripts(const char *path, char *error, int error_size) {
+    VmScripts *set = vm_parse_scripts(path, error, error_size);
+    if (set == NULL) return -1;
+
+    int count = set->count;
+    vm_free_scripts(vm_swap_scripts(set));
+    return count;
+}
+
+const VmProgram *vm_find_script(const char *name) {
+    const VmScripts *set = __atomic_load_n(&vm_live_scripts, __ATOMIC_ACQUIRE);
+    if (set == NULL) return NULL;
+
+    for (int i = 0; i < set->count; i++) {
+        if (strcmp(set->scripts[i].name, name) == 0) return &set->scripts[i].program;
+    }
+    return NULL;
+}
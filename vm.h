@@ -0,0 +1,100 @@
+#ifndef VM_H
+#define VM_H
+
+#include <stdint.h>
+
+#define VM_NUM_REGISTERS 16
+#define VM_MAX_CODE 256     // Instructions per script
+#define VM_MAX_SCRIPTS 64
+#define VM_MAX_SCRIPT_NAME 40
+#define VM_MAX_JUMPS 100000 // Jumps a script may take before it is stopped
+
+// Instructions are 32 bits: opcode, then three 8 bit operands a, b, c.
+// Instructions with an immediate keep a signed 16 bit value in b and c.
+// Registers are 32 bit and arithmetic wraps, no instruction can trap.
+typedef enum {
+    VM_OP_HALT,  // stop, result stays 0
+    VM_OP_RET,   // result = ra, stop
+    VM_OP_LOADI, // ra = imm16
+    VM_OP_MOV,   // ra = rb
+    VM_OP_LOAD,  // ra = field b
+    VM_OP_STORE, // field a = rb
+    VM_OP_ADD,   // ra = rb + rc
+    VM_OP_SUB,   // ra = rb - rc
+    VM_OP_MUL,   // ra = rb * rc
+    VM_OP_DIV,   // ra = rb / rc, 0 when rc is 0, -rb (wrapping) when rc is -1
+    VM_OP_MOD,   // ra = rb % rc, 0 when rc is 0 or -1
+    VM_OP_MIN,   // ra = min(rb, rc)
+    VM_OP_MAX,   // ra = max(rb, rc)
+    VM_OP_LT,    // ra = rb < rc
+    VM_OP_EQ,    // ra = rb == rc
+    VM_OP_ADDI,  // ra = rb + (signed) c
+    VM_OP_JMP,   // pc = imm16
+    VM_OP_JZ,    // if ra == 0, pc = imm16
+    VM_OP_JNZ,   // if ra != 0, pc = imm16
+    VM_OP_RAND,  // ra = random number in [0, rb)
+    VM_NUM_OPS
+} VmOp;
+
+// The only game state a script can touch
+typedef enum {
+    VM_FIELD_HEALTH,
+    VM_FIELD_MAX_HEALTH,
+    VM_FIELD_MANA,
+    VM_FIELD_MAX_MANA,
+    VM_FIELD_STRENGTH,
+    VM_FIELD_INTELLIGENCE,
+    VM_FIELD_AGILITY,
+    VM_FIELD_DEFENSE,
+    VM_FIELD_LEVEL,
+    VM_FIELD_EXPERIENCE,
+    VM_FIELD_GOLD,
+    VM_FIELD_ITEM_VALUE,
+    VM_FIELD_ITEM_RARITY,
+    VM_NUM_FIELDS
+} VmField;
+
+typedef struct {
+    uint32_t code[VM_MAX_CODE];
+    int length;
+} VmProgram;
+
+// Where fields live for this run. Unbound fields read as 0 and ignore writes.
+typedef struct {
+    int *fields[VM_NUM_FIELDS];
+    uint64_t rng;
+    int result;
+    int scratch;
+} VmContext;
+
+void vm_context_init(VmContext *context, uint64_t seed);
+void vm_bind(VmContext *context, VmField field, int *value);
+
+// Checks operands and jump targets so a program can not leave its sandbox
+int vm_verify(const VmProgram *program);
+
+// Runs a verified program. Returns 0 if it was stopped for jumping too much.
+int vm_run(const VmProgram *program, VmContext *context);
+
+// Assembles one script body, error gets a message when 0 is returned
+int vm_assemble(const char *source, VmProgram *program, char *error, int error_size);
+
+// A complete set of named scripts
+typedef struct VmScripts VmScripts;
+
+// Reads "script <name>" ... "end" blocks from a file, NULL on error
+VmScripts *vm_parse_scripts(const char *path, char *error, int error_size);
+
+// Makes scripts the live set and returns the old one. Programs found in
+// the old set may still be running, free it once nobody can be.
+VmScripts *vm_swap_scripts(VmScripts *scripts);
+void vm_free_scripts(VmScripts *scripts);
+
+// Parses and swaps in one go, for when no script can be running. Returns
+// the number of scripts loaded or -1 on error.
+int vm_load_scripts(const char *path, char *error, int error_size);
+
+// Looks in the live set, the program stays valid until the set is freed
+const VmProgram *vm_find_script(const char *name);
+
+#endif